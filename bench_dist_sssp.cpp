@@ -0,0 +1,369 @@
+// Scaling benchmark for DistributedSSSP::batchDelete against recomputing the
+// bounded BFS, across MPI ranks.
+//
+//   mpicxx -O3 -fopenmp -std=c++17 bench_dist_sssp.cpp -o bench_dist_sssp
+//   srun ./bench_dist_sssp --rmat 24 -L 8      (or mpirun -np P ...)
+//
+// The graph is never held by one rank: each rank generates (R-MAT) or reads
+// (edge-list file) its own share of the edges and DistributedSSSP routes them
+// to their owners.  The source structure is built, then a stream of deletion
+// batches is applied; after each batch the distributed BFS recomputes Dist over
+// the live edges, timed, and every rank checks its owned vertices against the
+// incremental answer.  Rank 0 writes one CSV row per batch to stdout:
+//
+//   graph,n,m,ranks,threads,source,L,batch,batch_size,killed,tree_edges,phases,max_U,
+//   supersteps,probes,ranks_scanned,enqueued,bytes_sent,incremental_s,recompute_s,speedup
+//
+// (counts are over all ranks; m counts distinct edges without self-loops.)
+//
+// Graph (one of):
+//   --rmat SCALE            R-MAT as in bench_sssp (same graph for the same seed),
+//                           --edge-factor edges per vertex (16); rank r generates
+//                           every ranks-th chunk
+//   --edges FILE            text edge list "u v" per line; each rank parses its
+//                           byte range of the file, cut at line starts
+//   --edges-bin FILE        binary edge list, native-endian int32 pairs
+// Run:
+//   -s V                    source (default: a vertex of largest out-degree)
+//   -L D                    depth bound (default 8)
+//   --batch-size B          deletions per batch, over all ranks (default 1000)
+//   --batches K             batches in the stream (default 10)
+//   --delete random|tree    random live edges, or edges of the current BFS tree;
+//                           each rank draws its share from the vertices it owns
+//   --seed X                generator and deletion seed (default 1)
+//   --no-header             skip the CSV header line
+//
+// Per-rank build time and share (owned vertices, in-edges, ghosts) go to stderr.
+
+#ifndef NO_DEMO_MAIN
+#define NO_DEMO_MAIN
+#endif
+#include "bfs_tree.cpp"
+#include "graph_io.cpp"
+#include "distributed_sssp.cpp"
+
+#include <mpi.h>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <omp.h>
+
+namespace {
+
+using Edge = std::pair<int,int>;
+
+// accepts 1000000 as well as 1e6
+long long parseCount(const std::string& s) {
+    double d = std::stod(s);
+    if (d < 0 || d > 2e9) {
+        throw std::out_of_range("count out of range: " + s);
+    }
+    return static_cast<long long>(d + 0.5);
+}
+
+struct Options {
+    std::string kind;                 // rmat, edges, edges-bin
+    std::string arg;                  // scale / file name
+    int edgeFactor = 16;
+    int source = -1;
+    int L = 8;
+    int batchSize = 1000;
+    int batches = 10;
+    bool treeDeletes = false;
+    uint64_t seed = 1;
+    bool header = true;
+};
+
+Options parseArgs(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::logic_error("missing value for " + a);
+            return argv[++i];
+        };
+        if (a == "--rmat" || a == "--edges" || a == "--edges-bin") {
+            o.kind = a.substr(2);
+            o.arg = next();
+        } else if (a == "--edge-factor") {
+            o.edgeFactor = static_cast<int>(parseCount(next()));
+        } else if (a == "-s") {
+            o.source = static_cast<int>(parseCount(next()));
+        } else if (a == "-L") {
+            o.L = static_cast<int>(parseCount(next()));
+        } else if (a == "--batch-size") {
+            o.batchSize = static_cast<int>(parseCount(next()));
+        } else if (a == "--batches") {
+            o.batches = static_cast<int>(parseCount(next()));
+        } else if (a == "--delete") {
+            std::string m = next();
+            if (m != "random" && m != "tree") throw std::logic_error("unknown delete mode " + m);
+            o.treeDeletes = (m == "tree");
+        } else if (a == "--seed") {
+            o.seed = static_cast<uint64_t>(parseCount(next()));
+        } else if (a == "--no-header") {
+            o.header = false;
+        } else {
+            throw std::logic_error("unknown option " + a);
+        }
+    }
+    if (o.kind.empty()) {
+        throw std::logic_error("no graph given (--rmat, --edges or --edges-bin)");
+    }
+    return o;
+}
+
+// ---- this rank's share of the input ----
+
+// The chunks of bench_sssp's rmatEdges with c % ranks == rank, relabelled by
+// the same permutation
+std::vector<Edge> rmatShare(int scale, int edgeFactor, uint64_t seed, int rank, int ranks) {
+    const int n = 1 << scale;
+    const long long m = static_cast<long long>(n) * edgeFactor;
+    const long long CHUNK = 1 << 16;
+    const long long chunks = (m + CHUNK - 1) / CHUNK;
+
+    std::vector<long long> mine;
+    for (long long c = rank; c < chunks; c += ranks) {
+        mine.push_back(c);
+    }
+    std::vector<long long> start(mine.size() + 1, 0);
+    for (size_t j = 0; j < mine.size(); ++j) {
+        start[j + 1] = start[j] + std::min(m, (mine[j] + 1) * CHUNK) - mine[j] * CHUNK;
+    }
+    std::vector<Edge> edges(start.back());
+
+    std::vector<int> label(n);
+    for (int v = 0; v < n; ++v) label[v] = v;
+    std::shuffle(label.begin(), label.end(), std::mt19937_64(seed));
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long long j = 0; j < static_cast<long long>(mine.size()); ++j) {
+        const long long c = mine[j];
+        std::mt19937_64 rng(seed * 0x9E3779B97F4A7C15ULL + c);
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        for (long long k = start[j]; k < start[j + 1]; ++k) {
+            int u = 0, v = 0;
+            for (int bit = 0; bit < scale; ++bit) {
+                double r = coin(rng);
+                if (r < 0.57) continue;           // a: neither bit set
+                if (r < 0.76) {                   // b
+                    v |= 1 << bit;
+                } else if (r < 0.95) {            // c
+                    u |= 1 << bit;
+                } else {                          // d
+                    u |= 1 << bit;
+                    v |= 1 << bit;
+                }
+            }
+            edges[k] = {label[u], label[v]};
+        }
+    }
+    return edges;
+}
+
+// The edges in this rank's 1/ranks of the file: bytes (text, boundaries moved
+// to line starts like edge_io::chunkBounds) or pairs (binary)
+std::vector<Edge> fileShare(const std::string& path, EdgeFormat fmt, int rank, int ranks) {
+    MappedFile file(path);
+    if (fmt == EdgeFormat::Binary && file.size() % 8 != 0) {
+        throw std::logic_error(path + ": size is not a multiple of 8 bytes (int32 pairs)");
+    }
+    const size_t units = (fmt == EdgeFormat::Text) ? file.size() : file.size() / 8;
+    auto lineStart = [&](size_t x) {
+        const char* d = file.data();
+        while (fmt == EdgeFormat::Text && x > 0 && x < units && d[x - 1] != '\n') ++x;
+        return x;
+    };
+    const size_t first = lineStart(units * rank / ranks);
+    const size_t last = lineStart(units * (rank + 1) / ranks);
+
+    const size_t chunks = std::min<size_t>(4 * omp_get_max_threads(), (last - first) / 4096 + 1);
+    std::vector<size_t> bounds(chunks + 1);
+    bounds[0] = first;
+    bounds[chunks] = last;
+    for (size_t c = 1; c < chunks; ++c) {
+        bounds[c] = std::min(last, std::max(bounds[c - 1], lineStart(first + (last - first) * c / chunks)));
+    }
+
+    std::vector<std::vector<Edge>> local(omp_get_max_threads());
+    edge_io::forEachEdge(file, fmt, bounds, [&](int u, int v) {
+        local[omp_get_thread_num()].push_back({u, v});
+    });
+    std::vector<Edge> edges;
+    for (auto& l : local) {
+        edges.insert(edges.end(), l.begin(), l.end());
+    }
+    return edges;
+}
+
+// ---- deletion batches ----
+
+// This rank's part of one batch: its share of batchSize, drawn from the live
+// out-edges it owns (each deleted once) or the tree edges into its vertices
+std::vector<Edge> drawShare(const Options& o, const DistributedSSSP& ds, std::vector<Edge>& pool,
+                            size_t& used, std::mt19937_64& rng) {
+    const int r = ds.rank();
+    const int P = ds.numRanks();
+    const size_t share = static_cast<size_t>(o.batchSize / P + (r < o.batchSize % P ? 1 : 0));
+
+    std::vector<Edge> batch;
+    if (o.treeDeletes) {
+        ds.forEachOwnedTreeEdge([&](int u, int v) { batch.push_back({u, v}); });
+        std::shuffle(batch.begin(), batch.end(), rng);
+        batch.resize(std::min(share, batch.size()));
+        return batch;
+    }
+    // pool is shuffled once; tree deletions never mix in, so pool[used..] is live
+    const size_t take = std::min(share, pool.size() - used);
+    batch.assign(pool.begin() + used, pool.begin() + used + take);
+    used += take;
+    return batch;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+    const int threads = omp_get_max_threads();
+
+    try {
+        Options o = parseArgs(argc, argv);
+
+        double t0 = MPI_Wtime();
+        int n = 0;
+        std::vector<Edge> edges;
+        if (o.kind == "rmat") {
+            int scale = static_cast<int>(parseCount(o.arg));
+            if (scale < 1 || scale > 30) throw std::out_of_range("--rmat: scale must be in [1, 30]");
+            n = 1 << scale;
+            edges = rmatShare(scale, o.edgeFactor, o.seed, rank, ranks);
+        } else {
+            edges = fileShare(o.arg, o.kind == "edges" ? EdgeFormat::Text : EdgeFormat::Binary, rank, ranks);
+            int maxId = -1;
+            for (auto [u, v] : edges) maxId = std::max(maxId, std::max(u, v));
+            n = mpi_exchange::maxRanks(MPI_COMM_WORLD, maxId) + 1;
+        }
+        if (n == 0) {
+            throw std::logic_error("empty graph");
+        }
+        const double tInput = MPI_Wtime() - t0;
+
+        // distinct out-edges at the owners of their tails give m and the
+        // default source: the largest out-degree, smallest id on ties (MPI_MAXLOC)
+        int s = o.source;
+        if (s >= n) {
+            throw std::out_of_range("-s: source out of range");
+        }
+        long long m = 0;
+        {
+            VertexPartition part(n, ranks);
+            mpi_exchange::Outbox<Edge> byTail(MPI_COMM_WORLD, ranks);
+            for (auto [u, v] : edges) {
+                if (u != v) byTail.push(part.owner(u), {u, v});
+            }
+            long long bytes = 0;
+            std::vector<Edge> out = byTail.exchange(bytes);
+            std::sort(out.begin(), out.end());
+            out.erase(std::unique(out.begin(), out.end()), out.end());
+            m = mpi_exchange::sumRanks(MPI_COMM_WORLD, static_cast<long long>(out.size()));
+
+            const int lo = part.begin(rank);
+            std::vector<int> deg(part.end(rank) - lo, 0);
+            for (auto [u, v] : out) ++deg[u - lo];
+            struct { int deg; int v; } best{-1, 0}, global{-1, 0};
+            for (int j = 0; j < static_cast<int>(deg.size()); ++j) {
+                if (deg[j] > best.deg) best = {deg[j], lo + j};
+            }
+            MPI_Allreduce(&best, &global, 1, MPI_2INT, MPI_MAXLOC, MPI_COMM_WORLD);
+            if (s < 0) s = global.v;
+        }
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        double t1 = MPI_Wtime();
+        DistributedSSSP ds(MPI_COMM_WORLD, n, edges, s, o.L);
+        double build = MPI_Wtime() - t1;
+        edges = std::vector<Edge>();
+        double buildMax = 0;
+        MPI_Reduce(&build, &buildMax, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        std::ostringstream share;   // one write, so the ranks' lines do not interleave
+        share << "bench_dist_sssp: rank " << rank << "/" << ranks << " threads=" << threads
+              << " input " << tInput << " s, build " << build << " s, owns " << ds.numOwned()
+              << " vertices, " << ds.numOwnedInEdges() << " in-edges, " << ds.numGhosts()
+              << " ghosts\n";
+        std::cerr << share.str();
+        if (rank == 0) {
+            std::cerr << "bench_dist_sssp: " << o.kind << " n=" << n << " m=" << m
+                      << " build " << buildMax << " s in " << ds.buildSupersteps() << " supersteps\n";
+            if (o.header) {
+                std::cout << "graph,n,m,ranks,threads,source,L,batch,batch_size,killed,tree_edges,"
+                             "phases,max_U,supersteps,probes,ranks_scanned,enqueued,bytes_sent,"
+                             "incremental_s,recompute_s,speedup\n";
+            }
+        }
+
+        std::mt19937_64 rng(o.seed + 7 + 1000003ULL * rank);
+        std::vector<Edge> pool;
+        size_t used = 0;
+        if (!o.treeDeletes) {
+            ds.forEachOwnedOutEdge([&](int u, int v) { pool.push_back({u, v}); });
+            std::shuffle(pool.begin(), pool.end(), rng);
+        }
+
+        for (int b = 0; b < o.batches; ++b) {
+            std::vector<Edge> batch = drawShare(o, ds, pool, used, rng);
+            const long long batchSize = mpi_exchange::sumRanks(MPI_COMM_WORLD, static_cast<long long>(batch.size()));
+            if (batchSize == 0) {
+                if (rank == 0) std::cerr << "bench_dist_sssp: no live edges left to delete\n";
+                break;
+            }
+
+            ds.batchDelete(batch);
+            const DistributedSSSP::BatchStats& st = ds.lastBatchStats();
+
+            MPI_Barrier(MPI_COMM_WORLD);
+            double t2 = MPI_Wtime();
+            std::vector<int> dist = ds.recompute();
+            double recompute = MPI_Wtime() - t2;
+            double recomputeMax = 0;
+            MPI_Allreduce(&recompute, &recomputeMax, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+            const std::vector<int> got = ds.localDistances();
+            int bad = -1;
+            for (size_t j = 0; j < got.size() && bad < 0; ++j) {
+                if (got[j] != dist[j]) bad = ds.partition().begin(rank) + static_cast<int>(j);
+            }
+            if (mpi_exchange::anyRank(MPI_COMM_WORLD, bad >= 0)) {
+                throw std::logic_error("Dist mismatch after deletion batch " + std::to_string(b) +
+                                       (bad >= 0 ? " at v=" + std::to_string(bad) : std::string(" on another rank")));
+            }
+
+            if (rank == 0) {
+                long long maxU = 0;
+                for (long long u : st.phaseU) maxU = std::max(maxU, u);
+                std::cout << o.kind << ',' << n << ',' << m << ',' << ranks << ',' << threads << ','
+                          << s << ',' << o.L << ',' << b << ',' << batchSize << ','
+                          << st.killed << ',' << st.treeEdges << ',' << st.phaseU.size() << ',' << maxU << ','
+                          << st.supersteps << ',' << st.probes << ',' << st.ranksScanned << ','
+                          << st.enqueued << ',' << st.bytesSent << ','
+                          << st.seconds << ',' << recomputeMax << ','
+                          << (st.seconds > 0 ? recomputeMax / st.seconds : 0.0) << '\n';
+                std::cout.flush();
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "bench_dist_sssp: rank " << rank << ": " << e.what() << "\n";
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,313 @@
+// Benchmark harness for the Lemma 3.1 PriorityStructure variants.
+//
+// Every variant defines the same class template, so the harness is compiled
+// once per variant with the variant's file pulled in through PS_SOURCE:
+//
+//   g++ -O3 -fopenmp -std=c++17 -DNO_DEMO_MAIN
+//       -DPS_SOURCE='"priority_struct_TAS.cpp"' bench_priority.cpp -o bench_tas
+//
+// and writes one CSV row per (threads, size, distribution, operation):
+//
+//   variant,threads,size,distribution,op,count,seconds,ns_per_op
+//
+// Options (all optional):
+//   --sizes 1000,100000     explicit sizes
+//   --max-size N            powers of ten from 10^3 up to N (default 10^6)
+//   --dists uniform,clustered,adversarial
+//   --threads 1,2,4,8       thread counts (default: 1 and omp_get_max_threads())
+//   --reps R                initialize repetitions, best time reported (default 3)
+//   --ops M                 operations per timed query/find/update run (default 10^6)
+//   --no-header             skip the CSV header line
+
+#ifndef PS_SOURCE
+#define PS_SOURCE "priority_struct_TAS.cpp"
+#endif
+#include PS_SOURCE
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <random>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+#include <omp.h>
+
+namespace {
+
+// variant name = PS_SOURCE with any directory and the .cpp stripped
+std::string variantName() {
+    std::string s = PS_SOURCE;
+    size_t slash = s.find_last_of('/');
+    if (slash != std::string::npos) s = s.substr(slash + 1);
+    size_t dot = s.rfind(".cpp");
+    if (dot != std::string::npos) s = s.substr(0, dot);
+    return s;
+}
+
+std::vector<std::string> splitList(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+// accepts 1000000 as well as 1e6
+long long parseCount(const std::string& s) {
+    double d = std::stod(s);
+    if (d < 1 || d > 2e9) {
+        throw std::out_of_range("count out of range: " + s);
+    }
+    return static_cast<long long>(d + 0.5);
+}
+
+struct Options {
+    std::vector<int> sizes;
+    std::vector<std::string> dists = {"uniform", "clustered", "adversarial"};
+    std::vector<int> threads;
+    int reps = 3;
+    int ops = 1000000;
+    bool header = true;
+};
+
+Options parseArgs(int argc, char** argv) {
+    Options o;
+    long long maxSize = 1000000;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::logic_error("missing value for " + a);
+            return argv[++i];
+        };
+        if (a == "--sizes") {
+            for (const auto& s : splitList(next())) o.sizes.push_back(static_cast<int>(parseCount(s)));
+        } else if (a == "--max-size") {
+            maxSize = parseCount(next());
+        } else if (a == "--dists") {
+            o.dists = splitList(next());
+        } else if (a == "--threads") {
+            for (const auto& s : splitList(next())) o.threads.push_back(static_cast<int>(parseCount(s)));
+        } else if (a == "--reps") {
+            o.reps = static_cast<int>(parseCount(next()));
+        } else if (a == "--ops") {
+            o.ops = static_cast<int>(parseCount(next()));
+        } else if (a == "--no-header") {
+            o.header = false;
+        } else {
+            throw std::logic_error("unknown option " + a);
+        }
+    }
+    if (o.sizes.empty()) {
+        for (long long n = 1000; n <= maxSize; n *= 10) o.sizes.push_back(static_cast<int>(n));
+    }
+    if (o.threads.empty()) {
+        o.threads.push_back(1);
+        if (omp_get_max_threads() > 1) o.threads.push_back(omp_get_max_threads());
+    }
+    for (const auto& d : o.dists) {
+        if (d != "uniform" && d != "clustered" && d != "adversarial") {
+            throw std::logic_error("unknown distribution " + d);
+        }
+    }
+    return o;
+}
+
+// Input for one (size, distribution) pair. Priorities are 2x for distinct
+// x in [1, B], so every odd priority is free and updatePriority can move an
+// element to its odd neighbour without changing any rank. Values are the
+// ranks at initialization (rank 1 = largest priority).
+struct Workload {
+    int maxP = 0;
+    std::vector<std::pair<int,int>> elems;  // (value, priority), in input order
+    std::vector<int> prioByRank;            // prioByRank[k-1] = priority of rank k
+};
+
+Workload makeWorkload(int n, const std::string& dist, uint64_t seed) {
+    Workload w;
+    std::mt19937_64 rng(seed);
+    std::vector<int> x(n);
+
+    if (dist == "uniform") {
+        // one x per stride-4 window of [1, 4n]
+        for (int i = 0; i < n; ++i) x[i] = 4 * i + 1 + static_cast<int>(rng() % 4);
+        w.maxP = 8 * n;
+    } else if (dist == "clustered") {
+        // 16 dense runs spread over [1, B]
+        const int clusters = 16;
+        const int B = std::max(4 * n, 4 * clusters);
+        const int span = B / clusters;
+        int i = 0;
+        for (int c = 0; c < clusters; ++c) {
+            int sz = n / clusters + (c < n % clusters ? 1 : 0);
+            for (int j = 0; j < sz; ++j) x[i++] = c * span + j + 1;
+        }
+        w.maxP = 2 * B;
+    } else {
+        // evenly spaced over the widest range that still fits in an int
+        const int B = 1 << 29;
+        const int stride = B / n;
+        for (int i = 0; i < n; ++i) x[i] = 1 + i * stride;
+        w.maxP = 2 * B;
+    }
+
+    // x is increasing, so rank of x[i] is n - i
+    w.elems.resize(n);
+    w.prioByRank.resize(n);
+    for (int i = 0; i < n; ++i) {
+        w.elems[i] = {n - i, 2 * x[i]};
+        w.prioByRank[n - i - 1] = 2 * x[i];
+    }
+
+    if (dist == "adversarial") {
+        // largest priority first: the worst case for insertion-based builds
+        std::reverse(w.elems.begin(), w.elems.end());
+    } else {
+        std::shuffle(w.elems.begin(), w.elems.end(), rng);
+    }
+    return w;
+}
+
+struct Row {
+    std::string variant;
+    int threads;
+    int size;
+    std::string dist;
+};
+
+void emit(const Row& r, const std::string& op, long long count, double seconds) {
+    std::cout << r.variant << ',' << r.threads << ',' << r.size << ',' << r.dist << ','
+              << op << ',' << count << ',' << seconds << ','
+              << (count > 0 ? seconds * 1e9 / count : 0.0) << '\n';
+}
+
+// results are folded in here so the timed loops cannot be optimized away
+volatile long long sink = 0;
+
+void benchOne(const Row& row, const Workload& w, const Options& o, uint64_t seed) {
+    using PS = PriorityStructure<int>;
+    const int n = row.size;
+    std::mt19937_64 rng(seed);
+
+    // INITIALIZE: fresh structure per repetition, best time kept
+    std::unique_ptr<PS> ps;
+    double best = 0;
+    for (int r = 0; r < o.reps; ++r) {
+        ps.reset();
+        auto fresh = std::make_unique<PS>(w.maxP);
+        double t0 = omp_get_wtime();
+        fresh->initialize(w.elems);
+        double t = omp_get_wtime() - t0;
+        if (r == 0 || t < best) best = t;
+        ps = std::move(fresh);
+    }
+    emit(row, "initialize", n, best);
+    if (ps->size() != n) {
+        throw std::logic_error("initialize: size mismatch");
+    }
+
+    std::vector<int> ranks(o.ops);
+    for (auto& k : ranks) k = 1 + static_cast<int>(rng() % n);
+    std::vector<int> prio = w.prioByRank;
+
+    // QUERY
+    {
+        long long acc = 0;
+        double t0 = omp_get_wtime();
+        for (int k : ranks) acc += ps->query(k);
+        double t = omp_get_wtime() - t0;
+        sink = sink + acc;
+        emit(row, "query", o.ops, t);
+    }
+
+    // FIND: priorities that are present
+    {
+        std::vector<int> keys(o.ops);
+        for (int i = 0; i < o.ops; ++i) keys[i] = prio[ranks[i] - 1];
+        long long acc = 0;
+        double t0 = omp_get_wtime();
+        for (int p : keys) acc += ps->find(p).second;
+        double t = omp_get_wtime() - t0;
+        sink = sink + acc;
+        emit(row, "find", o.ops, t);
+    }
+
+    // UPDATEPRIORITY: move rank k between its even priority and the odd one below
+    {
+        double t0 = omp_get_wtime();
+        for (int k : ranks) {
+            int p = prio[k - 1];
+            int q = (p % 2 == 0) ? p - 1 : p + 1;
+            ps->updatePriority(k, q);
+            prio[k - 1] = q;
+        }
+        double t = omp_get_wtime() - t0;
+        emit(row, "updatePriority", o.ops, t);
+    }
+
+    // NEXTWITH sweep: the match sits d ranks past k, for d = 1, 10, 100, ...;
+    // past d = 10 the number of calls shrinks so each run scans about 10 * ops ranks
+    for (long long d = 1; d < n; d *= 10) {
+        int calls = static_cast<int>(std::max(1LL, std::min<long long>(o.ops, 10LL * o.ops / d)));
+        std::vector<int> starts(calls);
+        for (auto& k : starts) k = 1 + static_cast<int>(rng() % (n - d));
+        std::vector<int> found(calls);
+        double t0 = omp_get_wtime();
+        for (int i = 0; i < calls; ++i) {
+            const int target = starts[i] + static_cast<int>(d);
+            found[i] = ps->nextWith(starts[i], [target](const int& v) { return v == target; });
+        }
+        double t = omp_get_wtime() - t0;
+        // values are the initial ranks, so the match must be exactly rank k + d
+        for (int i = 0; i < calls; ++i) {
+            if (found[i] != starts[i] + d) {
+                throw std::logic_error("nextWith(" + std::to_string(starts[i]) + ") returned " +
+                                       std::to_string(found[i]) + ", expected " +
+                                       std::to_string(starts[i] + d));
+            }
+        }
+        emit(row, "nextWith_d" + std::to_string(d), calls, t);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    try {
+        o = parseArgs(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "bench_priority: " << e.what() << "\n";
+        return 1;
+    }
+
+    const std::string variant = variantName();
+    if (o.header) {
+        std::cout << "variant,threads,size,distribution,op,count,seconds,ns_per_op\n";
+    }
+
+    for (int n : o.sizes) {
+        for (size_t di = 0; di < o.dists.size(); ++di) {
+            const uint64_t seed = 0x9E3779B97F4A7C15ULL * (static_cast<uint64_t>(n) + 31 * di + 1);
+            Workload w = makeWorkload(n, o.dists[di], seed);
+            for (int t : o.threads) {
+                omp_set_num_threads(t);
+                Row row{variant, t, n, o.dists[di]};
+                try {
+                    benchOne(row, w, o, seed + t);
+                } catch (const std::exception& e) {
+                    std::cerr << "bench_priority: " << variant << " n=" << n << " "
+                              << o.dists[di] << " threads=" << t << ": " << e.what() << "\n";
+                    return 1;
+                }
+                std::cout.flush();
+            }
+        }
+    }
+    return 0;
+}
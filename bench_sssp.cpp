@@ -0,0 +1,546 @@
+// Scaling benchmark for DynamicSSSP::batchDelete / batchInsert against
+// recomputing the BFS.
+//
+//   g++ -O3 -fopenmp -std=c++17 bench_sssp.cpp -o bench_sssp
+//
+// Builds (or loads) a graph, builds DynamicSSSP from source s with depth L,
+// then applies a stream of deletion batches, each optionally followed by an
+// insertion batch.  After every batch the same change is applied to a plain
+// CSR copy and bfs_array recomputes Dist from scratch, timed, and checked
+// against the incremental answer.  One CSV row per batch goes to stdout:
+//
+//   graph,n,m,threads,source,L,batch,op,batch_size,killed,inserted,tree_edges,phases,
+//   max_U,probes,ranks_scanned,enqueued,work,incremental_s,recompute_s,speedup,U_per_phase
+//
+// (op is delete or insert; incremental_s covers all of batchDelete / batchInsert;
+// U_per_phase is ';'-separated, and for inserts counts lowered vertices per level.)
+//
+// Graph (one of):
+//   --rmat SCALE            R-MAT, 2^SCALE vertices, --edge-factor edges per vertex (16)
+//   --grid ROWSxCOLS        2-D grid, edges both ways between 4-neighbours
+//   --er N                  Erdos-Renyi, N vertices, --avg-degree out-edges per vertex (8)
+//   --edges FILE            text edge list "u v" per line; '#' and '%' lines are comments
+//   --edges-bin FILE        binary edge list, native-endian int32 pairs
+// Run:
+//   -s V                    source (default: a vertex of largest out-degree)
+//   -L D                    depth bound (default 8)
+//   --batch-size B          deletions per batch (default 1000)
+//   --batches K             batches in the stream (default 10)
+//   --delete random|tree    random live edges, or edges of the current BFS tree
+//   --delete-file FILE      read the deletion batches from a text edge list instead,
+//                           an empty line or --batch-size edges ending each batch;
+//                           edges that are not live are dropped from the batch
+//   --delete-file-bin FILE  the same from a binary edge list
+//   --insert K              after each deletion batch insert K edges: half of them
+//                           edges deleted earlier in the stream, half new random pairs
+//   --snapshot FILE         save the built structure to FILE, load it back, and run
+//                           the stream on the loaded copy (times go to stderr)
+//   --threads 1,2,4         thread counts; the whole stream is rerun for each
+//   --numa                  NUMA placement (setNumaPlacement): per-socket vertex ranges,
+//                           first touch and owner-scheduled phases; needs pinned threads,
+//                           e.g. OMP_PLACES=sockets OMP_PROC_BIND=spread
+//   --seed X                generator and deletion seed (default 1)
+//   --no-header             skip the CSV header line
+//
+// Built with -DPS_ENABLE_COUNTERS, the PerfCounters snapshot of each stream is
+// written to stderr as JSON.
+
+#ifndef NO_DEMO_MAIN
+#define NO_DEMO_MAIN
+#endif
+#include "bfs_tree.cpp"
+#include "graph_io.cpp"
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <cstdint>
+#include <omp.h>
+
+namespace {
+
+using Edge = std::pair<int,int>;
+
+std::vector<std::string> splitList(const std::string& s, char sep = ',') {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, sep)) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+// accepts 1000000 as well as 1e6
+long long parseCount(const std::string& s) {
+    double d = std::stod(s);
+    if (d < 0 || d > 2e9) {
+        throw std::out_of_range("count out of range: " + s);
+    }
+    return static_cast<long long>(d + 0.5);
+}
+
+struct Options {
+    std::string kind;                 // rmat, grid, er, edges, edges-bin
+    std::string arg;                  // scale / RxC / n / file name
+    int edgeFactor = 16;
+    int avgDegree = 8;
+    int source = -1;
+    int L = 8;
+    int batchSize = 1000;
+    int batches = 10;
+    bool treeDeletes = false;
+    std::string deletePath;           // deletion batches from this file, if set
+    EdgeFormat deleteFormat = EdgeFormat::Text;
+    int inserts = 0;
+    std::string snapshotPath;
+    bool numa = false;
+    std::vector<int> threads;
+    uint64_t seed = 1;
+    bool header = true;
+};
+
+Options parseArgs(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::logic_error("missing value for " + a);
+            return argv[++i];
+        };
+        if (a == "--rmat" || a == "--grid" || a == "--er" || a == "--edges" ||
+            a == "--edges-bin") {
+            o.kind = a.substr(2);
+            o.arg = next();
+        } else if (a == "--edge-factor") {
+            o.edgeFactor = static_cast<int>(parseCount(next()));
+        } else if (a == "--avg-degree") {
+            o.avgDegree = static_cast<int>(parseCount(next()));
+        } else if (a == "-s") {
+            o.source = static_cast<int>(parseCount(next()));
+        } else if (a == "-L") {
+            o.L = static_cast<int>(parseCount(next()));
+        } else if (a == "--batch-size") {
+            o.batchSize = static_cast<int>(parseCount(next()));
+        } else if (a == "--batches") {
+            o.batches = static_cast<int>(parseCount(next()));
+        } else if (a == "--delete") {
+            std::string m = next();
+            if (m != "random" && m != "tree") throw std::logic_error("unknown delete mode " + m);
+            o.treeDeletes = (m == "tree");
+        } else if (a == "--delete-file" || a == "--delete-file-bin") {
+            o.deletePath = next();
+            o.deleteFormat = (a == "--delete-file") ? EdgeFormat::Text : EdgeFormat::Binary;
+        } else if (a == "--insert") {
+            o.inserts = static_cast<int>(parseCount(next()));
+        } else if (a == "--snapshot") {
+            o.snapshotPath = next();
+        } else if (a == "--numa") {
+            o.numa = true;
+        } else if (a == "--threads") {
+            for (const auto& t : splitList(next())) o.threads.push_back(static_cast<int>(parseCount(t)));
+        } else if (a == "--seed") {
+            o.seed = static_cast<uint64_t>(parseCount(next()));
+        } else if (a == "--no-header") {
+            o.header = false;
+        } else {
+            throw std::logic_error("unknown option " + a);
+        }
+    }
+    if (o.kind.empty()) {
+        throw std::logic_error("no graph given (--rmat, --grid, --er, --edges or --edges-bin)");
+    }
+    if (o.threads.empty()) {
+        o.threads.push_back(omp_get_max_threads());
+    }
+    return o;
+}
+
+// ---- graph generators ----
+
+// R-MAT (a, b, c, d) = (0.57, 0.19, 0.19, 0.05), vertex ids randomly relabelled
+// so that the hubs are not all at small ids.  Chunked so the result does not
+// depend on the thread count.
+std::vector<Edge> rmatEdges(int scale, int edgeFactor, uint64_t seed) {
+    const int n = 1 << scale;
+    const long long m = static_cast<long long>(n) * edgeFactor;
+    const long long CHUNK = 1 << 16;
+    std::vector<Edge> edges(m);
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long long c = 0; c < (m + CHUNK - 1) / CHUNK; ++c) {
+        std::mt19937_64 rng(seed * 0x9E3779B97F4A7C15ULL + c);
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        for (long long j = c * CHUNK; j < std::min(m, (c + 1) * CHUNK); ++j) {
+            int u = 0, v = 0;
+            for (int bit = 0; bit < scale; ++bit) {
+                double r = coin(rng);
+                if (r < 0.57) continue;           // a: neither bit set
+                if (r < 0.76) {                   // b
+                    v |= 1 << bit;
+                } else if (r < 0.95) {            // c
+                    u |= 1 << bit;
+                } else {                          // d
+                    u |= 1 << bit;
+                    v |= 1 << bit;
+                }
+            }
+            edges[j] = {u, v};
+        }
+    }
+
+    std::vector<int> label(n);
+    for (int v = 0; v < n; ++v) label[v] = v;
+    std::shuffle(label.begin(), label.end(), std::mt19937_64(seed));
+    #pragma omp parallel for
+    for (long long j = 0; j < m; ++j) {
+        edges[j] = {label[edges[j].first], label[edges[j].second]};
+    }
+    return edges;
+}
+
+std::vector<Edge> gridEdges(int rows, int cols) {
+    std::vector<Edge> edges;
+    edges.reserve(4LL * rows * cols);
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            int v = r * cols + c;
+            if (c + 1 < cols) { edges.push_back({v, v + 1});    edges.push_back({v + 1, v}); }
+            if (r + 1 < rows) { edges.push_back({v, v + cols}); edges.push_back({v + cols, v}); }
+        }
+    }
+    return edges;
+}
+
+std::vector<Edge> erEdges(int n, int avgDegree, uint64_t seed) {
+    const long long m = static_cast<long long>(n) * avgDegree;
+    std::vector<Edge> edges(m);
+    std::mt19937_64 rng(seed);
+    for (auto& e : edges) {
+        e = {static_cast<int>(rng() % n), static_cast<int>(rng() % n)};
+    }
+    return edges;
+}
+
+// adjacency lists without self-loops or parallel edges
+std::vector<std::vector<int>> toAdjacency(int n, const std::vector<Edge>& edges) {
+    std::vector<std::vector<int>> adj(n);
+    for (auto [u, v] : edges) {
+        if (u != v) adj[u].push_back(v);
+    }
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (int v = 0; v < n; ++v) {
+        std::sort(adj[v].begin(), adj[v].end());
+        adj[v].erase(std::unique(adj[v].begin(), adj[v].end()), adj[v].end());
+    }
+    return adj;
+}
+
+EdgeListGraph withTranspose(CSRGraph out) {
+    CSRGraph rev = out.transpose();
+    return {std::move(out), std::move(rev)};
+}
+
+// Out and Rev; files go through loadEdgeList, which builds both directly
+EdgeListGraph makeGraph(const Options& o) {
+    if (o.kind == "rmat") {
+        int scale = static_cast<int>(parseCount(o.arg));
+        if (scale < 1 || scale > 30) throw std::out_of_range("--rmat: scale must be in [1, 30]");
+        return withTranspose(CSRGraph(toAdjacency(1 << scale, rmatEdges(scale, o.edgeFactor, o.seed))));
+    }
+    if (o.kind == "grid") {
+        auto dims = splitList(o.arg, 'x');
+        if (dims.size() != 2) throw std::logic_error("--grid expects ROWSxCOLS");
+        int rows = static_cast<int>(parseCount(dims[0]));
+        int cols = static_cast<int>(parseCount(dims[1]));
+        return withTranspose(CSRGraph(toAdjacency(rows * cols, gridEdges(rows, cols))));
+    }
+    if (o.kind == "er") {
+        int n = static_cast<int>(parseCount(o.arg));
+        return withTranspose(CSRGraph(toAdjacency(n, erEdges(n, o.avgDegree, o.seed))));
+    }
+    return loadEdgeList(o.arg, o.kind == "edges" ? EdgeFormat::Text : EdgeFormat::Binary);
+}
+
+// ---- one run of the deletion stream ----
+
+// The reference graph: the original CSR (Out and its transpose, tombstoned)
+// plus the inserted edges that are not in it.
+struct Mirror {
+    CSRGraph out;
+    CSRGraph rev;
+    std::vector<std::vector<int>> extra;   // extra[u]: inserted out-neighbors of u
+    long long numExtra = 0;
+
+    explicit Mirror(const EdgeListGraph& graph)
+        : out(graph.out), rev(graph.rev), extra(graph.out.numVertices()) {
+        out.allocateTombstones();
+        rev.allocateTombstones();
+    }
+
+    // false if (u, v) is not live
+    bool remove(int u, int v) {
+        if (out.removeEdge(u, v)) {
+            rev.removeEdge(v, u);
+            return true;
+        }
+        auto it = std::find(extra[u].begin(), extra[u].end(), v);
+        if (it == extra[u].end()) {
+            return false;
+        }
+        extra[u].erase(it);
+        --numExtra;
+        return true;
+    }
+
+    // false if (u, v) is live already
+    bool insert(int u, int v) {
+        if (out.findEdge(u, v) >= 0 ||
+            std::find(extra[u].begin(), extra[u].end(), v) != extra[u].end()) {
+            return false;
+        }
+        if (out.restoreEdge(u, v)) {
+            rev.restoreEdge(v, u);
+        } else {
+            extra[u].push_back(v);
+            ++numExtra;
+        }
+        return true;
+    }
+
+    // direction-optimizing while the graph is a subgraph of the CSR
+    std::vector<int> bfs(int s, int L) const {
+        if (numExtra == 0) {
+            return bfs_array(out, rev, s, L);
+        }
+        return bfs_frontier(out.numVertices(), s, L, [&](int v, const auto& f) {
+            out.forEachNeighbor(v, f);
+            for (int w : extra[v]) f(w);
+        });
+    }
+};
+
+// Draw a batch of distinct live edges and delete them from the mirror, which
+// doubles as the dedup check.
+std::vector<Edge> drawBatch(const Options& o, const DynamicSSSP& ds,
+                            Mirror& mirror, std::mt19937_64& rng) {
+    std::vector<Edge> batch;
+    const CSRGraph& out = mirror.out;
+    const int n = out.numVertices();
+    const int m = out.numEdges();
+    long long attempts = 0;
+    const long long maxAttempts = 64LL * o.batchSize + 1024;
+
+    while (static_cast<int>(batch.size()) < o.batchSize && attempts++ < maxAttempts) {
+        int u, v;
+        if (o.treeDeletes) {
+            v = static_cast<int>(rng() % n);
+            u = ds.parent(v);
+            if (u < 0) continue;
+        } else {
+            if (m == 0) break;
+            int e = static_cast<int>(rng() % m);
+            if (out.isDeleted(e)) continue;
+            v = out.targets[e];
+            u = static_cast<int>(std::upper_bound(out.offsets.begin(), out.offsets.end(), e)
+                                 - out.offsets.begin()) - 1;
+        }
+        if (mirror.remove(u, v)) {
+            batch.push_back({u, v});
+        }
+    }
+    return batch;
+}
+
+// The next batch of the deletion file, minus the edges that are not live; the
+// rest are deleted from the mirror.  Empty once the file is exhausted.
+std::vector<Edge> readBatch(const Options& o, EdgeBatchStream& in, Mirror& mirror) {
+    std::vector<Edge> batch;
+    const int n = mirror.out.numVertices();
+    while (batch.empty() && !in.done()) {
+        for (auto [u, v] : in.next(o.batchSize)) {
+            if (u < 0 || v < 0 || u >= n || v >= n) {
+                throw std::out_of_range("deletion file: vertex id out of range");
+            }
+            if (mirror.remove(u, v)) {
+                batch.push_back({u, v});
+            }
+        }
+    }
+    return batch;
+}
+
+// Draw K distinct edges that are not live, alternating between edges deleted
+// earlier (taken out of the pool) and random new pairs, and insert them into
+// the mirror.
+std::vector<Edge> drawInsertBatch(const Options& o, Mirror& mirror, std::vector<Edge>& pool,
+                                  std::mt19937_64& rng) {
+    std::vector<Edge> batch;
+    const int n = mirror.out.numVertices();
+    long long attempts = 0;
+    const long long maxAttempts = 64LL * o.inserts + 1024;
+
+    while (static_cast<int>(batch.size()) < o.inserts && attempts++ < maxAttempts) {
+        Edge e;
+        if (batch.size() % 2 == 0 && !pool.empty()) {
+            size_t j = rng() % pool.size();
+            e = pool[j];
+            pool[j] = pool.back();
+            pool.pop_back();
+        } else {
+            e = {static_cast<int>(rng() % n), static_cast<int>(rng() % n)};
+            if (e.first == e.second) continue;
+        }
+        if (mirror.insert(e.first, e.second)) {
+            batch.push_back(e);
+        }
+    }
+    return batch;
+}
+
+void runStream(const Options& o, const EdgeListGraph& input, int s, int threads) {
+    omp_set_num_threads(threads);
+    std::mt19937_64 rng(o.seed + 7);
+    PerfCounters::reset();
+
+    const CSRGraph& graph = input.out;
+    Mirror mirror(input);
+    std::vector<Edge> pool;   // deleted edges, candidates for reinsertion
+    std::unique_ptr<EdgeBatchStream> deletions;
+    if (!o.deletePath.empty()) {
+        deletions = std::make_unique<EdgeBatchStream>(o.deletePath, o.deleteFormat);
+    }
+
+    double t0 = omp_get_wtime();
+    auto shared = std::make_shared<SharedGraph>(input.out, input.rev);
+    const int domains = shared->numaLayout().numDomains();
+    auto built = std::make_unique<DynamicSSSP>(std::move(shared), s, o.L);
+    std::cerr << "bench_sssp: threads=" << threads << " build "
+              << omp_get_wtime() - t0 << " s";
+    if (o.numa) {
+        std::cerr << ", " << domains << " NUMA domain" << (domains == 1 ? "" : "s");
+    }
+    std::cerr << "\n";
+
+    if (!o.snapshotPath.empty()) {
+        double ts = omp_get_wtime();
+        built->save(o.snapshotPath);
+        double tl = omp_get_wtime();
+        built.reset();
+        built = DynamicSSSP::load(o.snapshotPath);
+        std::cerr << "bench_sssp: threads=" << threads << " save " << tl - ts
+                  << " s, load " << omp_get_wtime() - tl << " s\n";
+    }
+    DynamicSSSP& ds = *built;
+
+    // apply one batch to ds, recompute from scratch, compare, print the row
+    auto step = [&](int b, bool insert, const std::vector<Edge>& batch) {
+        double t1 = omp_get_wtime();
+        if (insert) {
+            ds.batchInsert(batch);
+        } else {
+            ds.batchDelete(batch);
+        }
+        double incremental = omp_get_wtime() - t1;
+
+        double t2 = omp_get_wtime();
+        std::vector<int> dist = mirror.bfs(s, o.L);
+        double recompute = omp_get_wtime() - t2;
+
+        for (int v = 0; v < graph.numVertices(); ++v) {
+            if (ds.distance(v) != dist[v]) {
+                throw std::logic_error("Dist mismatch at v=" + std::to_string(v) + " after " +
+                                       (insert ? "insertion" : "deletion") +
+                                       " batch " + std::to_string(b));
+            }
+        }
+
+        const DynamicSSSP::BatchStats& st = ds.lastBatchStats();
+        int maxU = 0;
+        std::string perPhase;
+        for (size_t i = 0; i < st.phaseU.size(); ++i) {
+            maxU = std::max(maxU, st.phaseU[i]);
+            perPhase += (i ? ";" : "") + std::to_string(st.phaseU[i]);
+        }
+
+        std::cout << o.kind << ',' << graph.numVertices() << ',' << graph.numEdges() << ','
+                  << threads << ',' << s << ',' << o.L << ',' << b << ','
+                  << (insert ? "insert" : "delete") << ',' << batch.size() << ','
+                  << st.killed << ',' << st.inserted << ',' << st.treeEdges << ','
+                  << st.phaseU.size() << ',' << maxU << ','
+                  << st.probes << ',' << st.ranksScanned << ',' << st.enqueued << ',' << st.work() << ','
+                  << incremental << ',' << recompute << ','
+                  << (incremental > 0 ? recompute / incremental : 0.0) << ',' << perPhase << '\n';
+    };
+
+    for (int b = 0; b < o.batches; ++b) {
+        std::vector<Edge> batch = deletions ? readBatch(o, *deletions, mirror)
+                                            : drawBatch(o, ds, mirror, rng);
+        if (batch.empty()) {
+            std::cerr << (deletions ? "bench_sssp: deletion file exhausted\n"
+                                    : "bench_sssp: no live edges left to delete\n");
+            break;
+        }
+        step(b, false, batch);
+
+        if (o.inserts > 0) {
+            pool.insert(pool.end(), batch.begin(), batch.end());
+            std::vector<Edge> ins = drawInsertBatch(o, mirror, pool, rng);
+            if (!ins.empty()) {
+                step(b, true, ins);
+            }
+        }
+    }
+    std::cout.flush();
+
+    if (PerfCounters::enabled) {
+        std::cerr << "bench_sssp: counters, threads=" << threads << "\n"
+                  << PerfCounters::snapshot().toJSON();
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options o = parseArgs(argc, argv);
+        setNumaPlacement(o.numa);
+
+        double t0 = omp_get_wtime();
+        EdgeListGraph input = makeGraph(o);
+        const CSRGraph& graph = input.out;
+        std::cerr << "bench_sssp: " << o.kind << " n=" << graph.numVertices()
+                  << " m=" << graph.numEdges() << " in " << omp_get_wtime() - t0 << " s\n";
+        if (graph.numVertices() == 0) {
+            throw std::logic_error("empty graph");
+        }
+
+        int s = o.source;
+        if (s < 0) {
+            s = 0;
+            for (int v = 1; v < graph.numVertices(); ++v) {
+                if (graph.degree(v) > graph.degree(s)) s = v;
+            }
+        } else if (s >= graph.numVertices()) {
+            throw std::out_of_range("-s: source out of range");
+        }
+
+        if (o.header) {
+            std::cout << "graph,n,m,threads,source,L,batch,op,batch_size,killed,inserted,tree_edges,"
+                         "phases,max_U,probes,ranks_scanned,enqueued,work,incremental_s,recompute_s,"
+                         "speedup,U_per_phase\n";
+        }
+        for (int t : o.threads) {
+            runStream(o, input, s, t);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "bench_sssp: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -1,148 +1,1637 @@
 #include <iostream>
 #include <vector>
-#include <set>
 #include <functional>
-#include <unordered_set>
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <type_traits>
+#include <omp.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "gather_kernel.h"
+#include "perf_counters.h"
+
+
+// in-place inclusive prefix sum, blocked over the available threads
+inline void parallelPrefixSum(std::vector<int>& a) {
+    int m = static_cast<int>(a.size());
+    int nt = (m < (1 << 16)) ? 1 : omp_get_max_threads();
+    std::vector<int> blockSum(nt + 1, 0);
+
+    #pragma omp parallel num_threads(nt)
+    {
+        int t  = omp_get_thread_num();
+        int lo = static_cast<int>(static_cast<long long>(m) * t / nt);
+        int hi = static_cast<int>(static_cast<long long>(m) * (t + 1) / nt);
+
+        for (int i = lo + 1; i < hi; ++i) {
+            a[i] += a[i - 1];
+        }
+        blockSum[t + 1] = (lo < hi ? a[hi - 1] : 0);
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            for (int u = 1; u <= nt; ++u) {
+                blockSum[u] += blockSum[u - 1];
+            }
+        }
+
+        for (int i = lo; i < hi; ++i) {
+            a[i] += blockSum[t];
+        }
+    }
+}
+
+
+// Compressed sparse row graph: the out-neighbors of v are
+// targets[offsets[v] .. offsets[v+1]), each row sorted.  Deleted edges are
+// tombstoned in a bitmap (allocated on first delete) instead of being removed,
+// so edge positions stay stable and rows stay contiguous.
+struct CSRGraph {
+    int n = 0;
+    std::vector<int> offsets;          // size n+1
+    std::vector<int> targets;          // size m
+    std::vector<uint64_t> deleted;     // tombstones by edge position, empty if none
+
+    CSRGraph() = default;
+
+    explicit CSRGraph(const std::vector<std::vector<int>>& adj)
+        : n(adj.size()), offsets(adj.size() + 1, 0) {
+        for (int v = 0; v < n; ++v) {
+            offsets[v + 1] = offsets[v] + static_cast<int>(adj[v].size());
+        }
+        targets.resize(offsets[n]);
+
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int v = 0; v < n; ++v) {
+            std::copy(adj[v].begin(), adj[v].end(), targets.begin() + offsets[v]);
+            std::sort(targets.begin() + offsets[v], targets.begin() + offsets[v + 1]);
+        }
+    }
+
+    int numVertices() const { return n; }
+    int numEdges() const { return static_cast<int>(targets.size()); }
+    int degree(int v) const { return offsets[v + 1] - offsets[v]; }
+
+    bool isDeleted(int e) const {
+        return !deleted.empty() &&
+               ((__atomic_load_n(&deleted[e >> 6], __ATOMIC_RELAXED) >> (e & 63)) & 1);
+    }
+
+    // allocate the tombstone bitmap up front; removeEdge is then safe to call
+    // concurrently for distinct edges
+    void allocateTombstones() {
+        if (deleted.empty()) {
+            deleted.assign((targets.size() + 63) / 64, 0);
+        }
+    }
+
+    // position of a live edge (u, v), or -1
+    int findEdge(int u, int v) const {
+        auto first = targets.begin() + offsets[u];
+        auto last  = targets.begin() + offsets[u + 1];
+        for (auto it = std::lower_bound(first, last, v); it != last && *it == v; ++it) {
+            int e = static_cast<int>(it - targets.begin());
+            if (!isDeleted(e)) {
+                return e;
+            }
+        }
+        return -1;
+    }
+
+    // tombstone edge (u, v); false if there is no live such edge
+    bool removeEdge(int u, int v) {
+        int e = findEdge(u, v);
+        if (e < 0) {
+            return false;
+        }
+        allocateTombstones();
+        uint64_t bit = uint64_t(1) << (e & 63);
+        return !(__atomic_fetch_or(&deleted[e >> 6], bit, __ATOMIC_RELAXED) & bit);
+    }
+
+    // clear the tombstone of a deleted edge (u, v); false if there is no such edge
+    bool restoreEdge(int u, int v) {
+        if (deleted.empty()) {
+            return false;
+        }
+        auto first = targets.begin() + offsets[u];
+        auto last  = targets.begin() + offsets[u + 1];
+        for (auto it = std::lower_bound(first, last, v); it != last && *it == v; ++it) {
+            int e = static_cast<int>(it - targets.begin());
+            if (isDeleted(e)) {
+                uint64_t bit = uint64_t(1) << (e & 63);
+                return __atomic_fetch_and(&deleted[e >> 6], ~bit, __ATOMIC_RELAXED) & bit;
+            }
+        }
+        return false;
+    }
+
+    // f(u) for every live out-neighbor u of v
+    template <typename F>
+    void forEachNeighbor(int v, F&& f) const {
+        for (int e = offsets[v]; e < offsets[v + 1]; ++e) {
+            if (!isDeleted(e)) {
+                f(targets[e]);
+            }
+        }
+    }
+
+    // true if f(u) holds for some live out-neighbor u of v; stops at the first one
+    template <typename F>
+    bool anyNeighbor(int v, F&& f) const {
+        for (int e = offsets[v]; e < offsets[v + 1]; ++e) {
+            if (!isDeleted(e) && f(targets[e])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // true if some (sorted) row lists the same target twice
+    bool hasRepeatedTargets() const {
+        bool repeated = false;
+        #pragma omp parallel for schedule(dynamic, 1024) reduction(||:repeated)
+        for (int v = 0; v < n; ++v) {
+            auto first = targets.begin() + offsets[v];
+            auto last  = targets.begin() + offsets[v + 1];
+            repeated = repeated || std::adjacent_find(first, last) != last;
+        }
+        return repeated;
+    }
+
+    // Drop repeated targets from the (sorted) rows and close the gaps.  Edge
+    // positions change, so this is for a graph with no tombstones yet.
+    void compactRows() {
+        if (!deleted.empty()) {
+            throw std::logic_error("compactRows: graph already has deleted edges");
+        }
+        std::vector<int> deg(n + 1, 0);
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int v = 0; v < n; ++v) {
+            auto first = targets.begin() + offsets[v];
+            auto last  = targets.begin() + offsets[v + 1];
+            deg[v + 1] = static_cast<int>(std::unique(first, last) - first);
+        }
+        parallelPrefixSum(deg);
+
+        std::vector<int> kept(deg[n]);
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int v = 0; v < n; ++v) {
+            std::copy(targets.begin() + offsets[v], targets.begin() + offsets[v] + (deg[v + 1] - deg[v]),
+                      kept.begin() + deg[v]);
+        }
+        offsets.swap(deg);
+        targets.swap(kept);
+    }
+
+    // reverse graph over the live edges: row v lists the in-neighbors of v, sorted
+    CSRGraph transpose() const {
+        CSRGraph R;
+        R.n = n;
+        R.offsets.assign(n + 1, 0);
+
+        // in-degree counts, shifted by one for the prefix sum
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int u = 0; u < n; ++u) {
+            forEachNeighbor(u, [&](int v) {
+                __atomic_fetch_add(&R.offsets[v + 1], 1, __ATOMIC_RELAXED);
+            });
+        }
+        parallelPrefixSum(R.offsets);
+
+        R.targets.resize(R.offsets[n]);
+        std::vector<int> fill(R.offsets.begin(), R.offsets.end() - 1);
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int u = 0; u < n; ++u) {
+            forEachNeighbor(u, [&](int v) {
+                R.targets[__atomic_fetch_add(&fill[v], 1, __ATOMIC_RELAXED)] = u;
+            });
+        }
+
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int v = 0; v < n; ++v) {
+            std::sort(R.targets.begin() + R.offsets[v], R.targets.begin() + R.offsets[v + 1]);
+        }
+        return R;
+    }
+};
+
+
+
+// frontier size below which a level is expanded without opening a team
+constexpr int BFS_PARALLEL_THRESH = 1 << 10;
+
+// Direction-optimizing heuristic (Beamer et al.): go bottom-up once the edges
+// out of the frontier exceed 1/alpha of the edges out of unvisited vertices,
+// and back top-down once the frontier holds fewer than n/beta vertices.
+constexpr int BFS_ALPHA = 15;
+constexpr int BFS_BETA  = 18;
+
+enum class BFSDirection { TopDown, BottomUp };
+
+// per-thread buffers for building a frontier, reused across levels
+struct FrontierBuffers {
+    std::vector<std::vector<int>> local;
+    std::vector<size_t> offset;
+
+    FrontierBuffers() : local(omp_get_max_threads()), offset(local.size() + 1, 0) {}
+
+    // called by every thread of the team: concatenate the buffers into out
+    void concat(std::vector<int>& out) {
+        #pragma omp single
+        {
+            int nt = omp_get_num_threads();
+            for (int q = 0; q < nt; ++q) {
+                offset[q + 1] = offset[q] + local[q].size();
+            }
+            out.resize(offset[nt]);
+        }
+
+        int t = omp_get_thread_num();
+        std::copy(local[t].begin(), local[t].end(), out.begin() + offset[t]);
+    }
+};
+
+// Top-down step S(i) -> S(i+1): a vertex is claimed by a CAS of dist[u] from
+// unseen to d, so it enters exactly one thread's buffer.
+// forEachNeighbor(v, f) calls f(u) for every out-neighbor u of v.
+template <typename ForEachNeighbor>
+void bfs_top_down_step(const std::vector<int>& curr, std::vector<int>& next,
+                       std::vector<int>& dist, int d, int unseen,
+                       FrontierBuffers& buf, const ForEachNeighbor& forEachNeighbor) {
+    const int frontier = static_cast<int>(curr.size());
+
+    #pragma omp parallel if(frontier >= BFS_PARALLEL_THRESH)
+    {
+        std::vector<int>& mine = buf.local[omp_get_thread_num()];
+        mine.clear();
+
+        #pragma omp for schedule(dynamic, 64)
+        for (int j = 0; j < frontier; ++j) {
+            forEachNeighbor(curr[j], [&](int u) {
+                int expected = unseen;
+                if (__atomic_load_n(&dist[u], __ATOMIC_RELAXED) == unseen &&
+                    __atomic_compare_exchange_n(&dist[u], &expected, d, false,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                    mine.push_back(u);
+                }
+            });
+        }
+
+        buf.concat(next);
+    }
+}
+
+// Level-synchronous BFS up to depth L over flat frontiers S(i).
+// Each thread collects its claims in a local buffer; the buffers are
+// concatenated at prefix-sum offsets to form S(i+1).
+template <typename ForEachNeighbor>
+std::vector<int> bfs_frontier(int n, int s, int L, const ForEachNeighbor& forEachNeighbor) {
+    const int unseen = L + 1;
+    std::vector<int> dist(n, unseen);
+
+    // Initialize: S(0) = {s}
+    dist[s] = 0;
+    std::vector<int> curr{s};
+    std::vector<int> next;
+    FrontierBuffers buf;
+
+    // BFS by levels up to depth L; levels are sequential, each level is parallel
+    for (int i = 0; i < L && !curr.empty(); ++i) {
+        bfs_top_down_step(curr, next, dist, i + 1, unseen, buf, forEachNeighbor);
+        curr.swap(next);
+    }
+    return dist;
+}
+
+std::vector<int> bfs_array(const std::vector<std::vector<int>>& adj, int s, int L) {
+    return bfs_frontier(static_cast<int>(adj.size()), s, L, [&](int v, const auto& f) {
+        for (int u : adj[v]) {  // iterate over out-neighbors
+            f(u);
+        }
+    });
+}
+
+// same BFS over a CSR graph; tombstoned edges are skipped
+std::vector<int> bfs_array(const CSRGraph& G, int s, int L) {
+    return bfs_frontier(G.numVertices(), s, L, [&](int v, const auto& f) {
+        G.forEachNeighbor(v, f);  // iterate over live out-neighbors
+    });
+}
+
+// Direction-optimizing BFS up to depth L.  Gr is the reverse of G (G.transpose()).
+// Top-down levels expand the frontier vector as above; bottom-up levels keep the
+// frontier as a bitmap and let every unvisited v look for an in-neighbor in it,
+// stopping at the first hit.  The direction chosen for each level is appended
+// to *directions if given.
+std::vector<int> bfs_array(const CSRGraph& G, const CSRGraph& Gr, int s, int L,
+                           std::vector<BFSDirection>* directions = nullptr,
+                           int alpha = BFS_ALPHA, int beta = BFS_BETA) {
+    const int n = G.numVertices();
+    const int words = (n + 63) / 64;
+    const int unseen = L + 1;
+    std::vector<int> dist(n, unseen);
+
+    dist[s] = 0;
+    std::vector<int> curr{s};
+    std::vector<int> next;
+    std::vector<uint64_t> currBits;
+    std::vector<uint64_t> nextBits;
+    FrontierBuffers buf;
+
+    if (directions) {
+        directions->clear();
+    }
+
+    bool bottomUp = false;
+    long long frontierSize  = 1;
+    long long frontierEdges = G.degree(s);                 // m_f
+    long long unseenEdges   = G.numEdges() - G.degree(s);  // m_u
+
+    for (int i = 0; i < L && frontierSize > 0; ++i) {
+        const int d = i + 1;
+
+        if (!bottomUp && frontierEdges > unseenEdges / alpha) {
+            // vector -> bitmap
+            currBits.assign(words, 0);
+            #pragma omp parallel for if(curr.size() >= BFS_PARALLEL_THRESH)
+            for (size_t j = 0; j < curr.size(); ++j) {
+                __atomic_fetch_or(&currBits[curr[j] >> 6], uint64_t(1) << (curr[j] & 63),
+                                  __ATOMIC_RELAXED);
+            }
+            bottomUp = true;
+        } else if (bottomUp && frontierSize < n / beta) {
+            // bitmap -> vector
+            #pragma omp parallel if(words * 64 >= BFS_PARALLEL_THRESH)
+            {
+                std::vector<int>& mine = buf.local[omp_get_thread_num()];
+                mine.clear();
+
+                #pragma omp for schedule(static)
+                for (int w = 0; w < words; ++w) {
+                    for (uint64_t bits = currBits[w]; bits; bits &= bits - 1) {
+                        mine.push_back(w * 64 + __builtin_ctzll(bits));
+                    }
+                }
+
+                buf.concat(curr);
+            }
+            bottomUp = false;
+        }
+
+        if (directions) {
+            directions->push_back(bottomUp ? BFSDirection::BottomUp : BFSDirection::TopDown);
+        }
+
+        long long newSize = 0;
+        long long newEdges = 0;
+        if (bottomUp) {
+            // each word of the next bitmap is owned by one thread: no atomics needed
+            nextBits.assign(words, 0);
+            #pragma omp parallel for schedule(dynamic, 64) reduction(+:newSize, newEdges) \
+                    if(words * 64 >= BFS_PARALLEL_THRESH)
+            for (int w = 0; w < words; ++w) {
+                uint64_t found = 0;
+                int hi = std::min(n, w * 64 + 64);
+                for (int v = w * 64; v < hi; ++v) {
+                    if (dist[v] != unseen) {
+                        continue;
+                    }
+                    bool hit = Gr.anyNeighbor(v, [&](int u) {
+                        return (currBits[u >> 6] >> (u & 63)) & 1;
+                    });
+                    if (hit) {
+                        dist[v] = d;
+                        found |= uint64_t(1) << (v & 63);
+                        newSize += 1;
+                        newEdges += G.degree(v);
+                    }
+                }
+                nextBits[w] = found;
+            }
+            currBits.swap(nextBits);
+        } else {
+            bfs_top_down_step(curr, next, dist, d, unseen, buf, [&](int v, const auto& f) {
+                G.forEachNeighbor(v, f);
+            });
+            curr.swap(next);
+
+            newSize = static_cast<long long>(curr.size());
+            #pragma omp parallel for reduction(+:newEdges) if(newSize >= BFS_PARALLEL_THRESH)
+            for (long long j = 0; j < newSize; ++j) {
+                newEdges += G.degree(curr[j]);
+            }
+        }
+
+        frontierSize  = newSize;
+        frontierEdges = newEdges;
+        unseenEdges  -= newEdges;
+    }
+    return dist;
+}
+
+
+// Binary snapshots (DynamicSSSP::save / load).  A file is an 8-byte magic, a
+// version and a byte-order mark, then a sequence of items: scalars as 8-byte
+// slots, arrays as an 8-byte element count followed by the raw elements padded
+// to 64 bytes, so every array starts cache-line aligned in the mapping.  Items
+// carry no names; writer and reader walk the same order.  Loading is an eager
+// binary load, not a lazy one: every array is copied into the structures'
+// own vectors before load returns.  In(v) needs no item of its own, since it
+// is the rows of Rev.
+namespace snapshot {
+
+constexpr char MAGIC[8] = {'D', 'S', 'S', 'P', 'S', 'N', 'A', 'P'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t ORDER_MARK = 0x01020304;
+constexpr size_t ALIGN = 64;
+
+// arrays at least this long (in bytes) are copied out of the mapping by the team
+constexpr size_t PARALLEL_COPY_BYTES = size_t(1) << 22;
+
+class Writer {
+public:
+    explicit Writer(const std::string& path)
+        : path(path), out(path, std::ios::binary | std::ios::trunc) {
+        if (!out) {
+            throw std::logic_error("snapshot: cannot create " + path);
+        }
+        out.write(MAGIC, sizeof(MAGIC));
+        uint32_t head[2] = {VERSION, ORDER_MARK};
+        out.write(reinterpret_cast<const char*>(head), sizeof(head));
+    }
+
+    template <typename T>
+    void put(T x) {
+        static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= 8, "scalar item");
+        char slot[8] = {};
+        std::memcpy(slot, &x, sizeof(T));
+        out.write(slot, sizeof(slot));
+    }
+
+    template <typename T>
+    void putArray(const T* data, size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "array item");
+        put<uint64_t>(count);
+        out.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+        static const char zeros[ALIGN] = {};
+        out.write(zeros, (ALIGN - out.tellp() % ALIGN) % ALIGN);
+    }
+
+    template <typename T>
+    void putArray(const std::vector<T>& a) {
+        putArray(a.data(), a.size());
+    }
+
+    // flush and report a failed write
+    void finish() {
+        out.flush();
+        if (!out) {
+            throw std::logic_error("snapshot: write failed for " + path);
+        }
+    }
+
+private:
+    std::string path;
+    std::ofstream out;
+};
+
+// Maps the file read-only for its lifetime, with read-ahead requested for
+// all of it; getArray copies each array out in parallel chunks, and nothing
+// refers to the mapping once the reader is gone.
+class Reader {
+public:
+    explicit Reader(const std::string& path) : path(path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::logic_error("snapshot: cannot open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(MAGIC) + 8)) {
+            ::close(fd);
+            throw std::logic_error("snapshot: not a snapshot file: " + path);
+        }
+        size = static_cast<size_t>(st.st_size);
+        void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            throw std::logic_error("snapshot: cannot map " + path);
+        }
+        base = static_cast<const char*>(p);
+        ::madvise(p, size, MADV_WILLNEED);
+
+        uint32_t head[2];
+        std::memcpy(head, base + sizeof(MAGIC), sizeof(head));
+        if (std::memcmp(base, MAGIC, sizeof(MAGIC)) != 0 ||
+            head[0] != VERSION || head[1] != ORDER_MARK) {
+            ::munmap(p, size);
+            throw std::logic_error("snapshot: bad magic, version or byte order in " + path);
+        }
+        pos = sizeof(MAGIC) + sizeof(head);
+    }
+
+    ~Reader() {
+        ::munmap(const_cast<char*>(base), size);
+    }
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= 8, "scalar item");
+        need(8);
+        T x;
+        std::memcpy(&x, base + pos, sizeof(T));
+        pos += 8;
+        return x;
+    }
+
+    template <typename T>
+    std::vector<T> getArray() {
+        static_assert(std::is_trivially_copyable<T>::value, "array item");
+        const uint64_t count = get<uint64_t>();
+        if (count > (size - pos) / sizeof(T)) {
+            fail("truncated array");
+        }
+        const size_t bytes = count * sizeof(T);
+        std::vector<T> a(count);
+        char* dst = reinterpret_cast<char*>(a.data());
+        const char* src = base + pos;
+
+        const long long chunks = static_cast<long long>((bytes + PARALLEL_COPY_BYTES - 1) / PARALLEL_COPY_BYTES);
+        #pragma omp parallel for schedule(static) if(chunks > 1)
+        for (long long c = 0; c < chunks; ++c) {
+            size_t lo = c * PARALLEL_COPY_BYTES;
+            std::memcpy(dst + lo, src + lo, std::min(PARALLEL_COPY_BYTES, bytes - lo));
+        }
+
+        pos += bytes;
+        pos = std::min(size, pos + (ALIGN - pos % ALIGN) % ALIGN);
+        return a;
+    }
+
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::logic_error("snapshot: " + what + " in " + path);
+    }
+
+private:
+    std::string path;
+    const char* base = nullptr;
+    size_t size = 0;
+    size_t pos = 0;
+
+    void need(size_t bytes) const {
+        if (bytes > size - pos) {
+            fail("unexpected end of file");
+        }
+    }
+};
+
+} // namespace snapshot
 
 
-template <typename T>
-class PriorityStructure;
+// NUMA placement.  With placement on, the vertices of a SharedGraph are cut
+// into contiguous ranges, one per socket of the OpenMP team it was built for
+// (balanced by in-degree + 1), and each range is first-touched by the threads
+// of its socket: per source, Dist, Scan, Parent, T and the batch scratch.
+// batchDelete phases then hand each thread the vertices of its own socket
+// first.  The sockets are read from the thread-to-place binding, so threads
+// must be pinned (e.g. OMP_PLACES=sockets OMP_PROC_BIND=spread); unpinned
+// teams and single-socket nodes get one domain and the plain schedule.
+inline std::atomic<bool>& numaPlacementChoice() {
+    static std::atomic<bool> choice{false};
+    return choice;
+}
+
+inline bool numaPlacement() {
+    return numaPlacementChoice().load(std::memory_order_relaxed);
+}
+
+// applies to graphs built from now on
+inline void setNumaPlacement(bool on) {
+    numaPlacementChoice().store(on, std::memory_order_relaxed);
+}
+
+class NumaLayout {
+public:
+    // one domain: placement and scheduling are left as they are
+    NumaLayout() = default;
+
+    // ranges for n vertices with in-edge offsets inOffsets, for a team of
+    // omp_get_max_threads() threads
+    NumaLayout(int n, const std::vector<int>& inOffsets) : bounds{0, n} {
+        threadDomain = threadSockets();
+        teamSize = static_cast<int>(threadDomain.size());
+        domains = 1 + *std::max_element(threadDomain.begin(), threadDomain.end());
+        if (domains == 1) {
+            return;
+        }
+
+        // domain d starts at the first v with v + inOffsets[v] >= d * (n + m) / domains
+        const long long total = static_cast<long long>(n) + inOffsets[n];
+        bounds.assign(domains + 1, n);
+        bounds[0] = 0;
+        int v = 0;
+        for (int d = 1; d < domains; ++d) {
+            const long long cut = total * d / domains;
+            while (v < n && v + static_cast<long long>(inOffsets[v]) < cut) {
+                ++v;
+            }
+            bounds[d] = v;
+        }
+
+        threadRank.assign(teamSize, 0);
+        domainThreads.assign(domains, 0);
+        for (int t = 0; t < teamSize; ++t) {
+            int d = threadDomain[t];
+            threadRank[t] = domainThreads[d]++;
+        }
+    }
+
+    bool active() const {
+        return domains > 1;
+    }
+
+    int numDomains() const {
+        return domains;
+    }
+
+    // domain d owns vertices [begin(d), end(d))
+    int begin(int d) const { return bounds[d]; }
+    int end(int d) const { return bounds[d + 1]; }
+
+    int domainOf(int v) const {
+        return static_cast<int>(std::upper_bound(bounds.begin() + 1, bounds.end() - 1, v) -
+                                (bounds.begin() + 1));
+    }
+
+    // domain of thread t of the current team; teams of another size than the
+    // layout was made for are spread round-robin, which is correct but unplaced
+    int threadDomainOf(int t) const {
+        if (omp_get_num_threads() == teamSize) {
+            return threadDomain[t];
+        }
+        return t % domains;
+    }
+
+    // f(v) for every vertex, each by a thread of its domain.  Opens its own
+    // team.  With chunk == 0 every thread takes a static slice of its domain's
+    // range (page placement); otherwise the domain's threads claim chunks of
+    // it (uneven work), but never leave it.
+    template <typename F>
+    void forEachOwned(F&& f, int chunk = 0) const {
+        const int n = bounds[domains];
+        std::vector<std::atomic<int>> cursor(domains);
+        for (int d = 0; d < domains; ++d) {
+            cursor[d].store(bounds[d], std::memory_order_relaxed);
+        }
+
+        #pragma omp parallel num_threads(teamSize)
+        {
+            const int t = omp_get_thread_num();
+            const int nt = omp_get_num_threads();
+            if (nt != teamSize) {
+                // not the team the layout was made for: plain static split
+                const int lo = static_cast<int>(static_cast<long long>(n) * t / nt);
+                const int hi = static_cast<int>(static_cast<long long>(n) * (t + 1) / nt);
+                for (int v = lo; v < hi; ++v) {
+                    f(v);
+                }
+            } else if (chunk == 0) {
+                const int d = threadDomain[t];
+                const long long len = bounds[d + 1] - bounds[d];
+                const int lo = bounds[d] + static_cast<int>(len * threadRank[t] / domainThreads[d]);
+                const int hi = bounds[d] + static_cast<int>(len * (threadRank[t] + 1) / domainThreads[d]);
+                for (int v = lo; v < hi; ++v) {
+                    f(v);
+                }
+            } else {
+                const int d = threadDomain[t];
+                for (;;) {
+                    const int lo = cursor[d].fetch_add(chunk, std::memory_order_relaxed);
+                    if (lo >= bounds[d + 1]) {
+                        break;
+                    }
+                    const int hi = std::min(lo + chunk, bounds[d + 1]);
+                    for (int v = lo; v < hi; ++v) {
+                        f(v);
+                    }
+                }
+            }
+        }
+    }
+
+    // a.assign(n, value), with every page first touched by its owning domain
+    template <typename T>
+    void fill(std::vector<T>& a, int n, const T& value) const {
+        if (!active()) {
+            a.assign(n, value);
+            return;
+        }
+        a.assign(n, T());
+        releasePages(a.data(), a.size() * sizeof(T));
+        forEachOwned([&](int v) { a[v] = value; });
+    }
+
+    // a = src, placed like fill
+    template <typename T>
+    void copy(std::vector<T>& a, const std::vector<T>& src) const {
+        if (!active()) {
+            a = src;
+            return;
+        }
+        a.assign(src.size(), T());
+        releasePages(a.data(), a.size() * sizeof(T));
+        forEachOwned([&](int v) { a[v] = src[v]; });
+    }
+
+    // a = std::move(src) when there is nothing to place
+    template <typename T>
+    void place(std::vector<T>& a, std::vector<T>&& src) const {
+        if (!active()) {
+            a = std::move(src);
+            return;
+        }
+        copy(a, src);
+    }
+
+private:
+    int domains = 1;
+    int teamSize = 1;
+    std::vector<int> bounds{0, 0};
+    std::vector<int> threadDomain{0};   // socket of thread t, numbered from 0
+    std::vector<int> threadRank{0};     // t is the threadRank[t]-th thread of its socket
+    std::vector<int> domainThreads{1};  // threads per socket
+
+    // socket of each thread of a team of omp_get_max_threads(), renumbered in
+    // order of first appearance; all 0 unless placement is on and threads are bound
+    static std::vector<int> threadSockets() {
+        const int nt = omp_get_max_threads();
+        std::vector<int> package(nt, 0);
+        if (!numaPlacement()) {
+            return package;
+        }
+        #pragma omp parallel num_threads(nt)
+        {
+            const int place = omp_get_place_num();
+            if (place >= 0 && omp_get_place_num_procs(place) > 0) {
+                std::vector<int> procs(omp_get_place_num_procs(place));
+                omp_get_place_proc_ids(place, procs.data());
+                package[omp_get_thread_num()] = cpuPackage(procs[0]);
+            }
+        }
+        std::vector<int> ids;
+        for (int& p : package) {
+            auto it = std::find(ids.begin(), ids.end(), p);
+            if (it == ids.end()) {
+                ids.push_back(p);
+                it = ids.end() - 1;
+            }
+            p = static_cast<int>(it - ids.begin());
+        }
+        return package;
+    }
+
+    static int cpuPackage(int cpu) {
+        std::ifstream in("/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                         "/topology/physical_package_id");
+        int id = 0;
+        return (in >> id) ? id : 0;
+    }
+
+    // Drop the whole pages of [p, p + bytes): they read back as zeros, and the
+    // next write to each one allocates it on the writer's node.  Only the pages
+    // strictly inside the array are dropped, so neighbouring data is untouched.
+    static void releasePages(void* p, size_t bytes) {
+        const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        const uintptr_t lo = (reinterpret_cast<uintptr_t>(p) + page - 1) & ~(page - 1);
+        const uintptr_t hi = (reinterpret_cast<uintptr_t>(p) + bytes) & ~(page - 1);
+        if (hi > lo) {
+            madvise(reinterpret_cast<void*>(lo), hi - lo, MADV_DONTNEED);
+        }
+    }
+};
+
+
+// A list of vertices grouped by owning domain, for one loop inside a parallel
+// region.  Each thread takes chunks of its own domain's group and, once that is
+// empty, helps the other domains in turn: most of the work reads and writes the
+// local socket, and no thread idles while another domain still has work.
+class OwnerQueue {
+public:
+    OwnerQueue(const NumaLayout& numa, const std::vector<int>& vertices, int chunk)
+        : numa(numa), chunk(chunk), order(vertices.size()), start(numa.numDomains() + 1, 0),
+          cursor(numa.numDomains())
+    {
+        const int D = numa.numDomains();
+        std::vector<int> domain(vertices.size());
+        for (size_t j = 0; j < vertices.size(); ++j) {
+            domain[j] = numa.domainOf(vertices[j]);
+            ++start[domain[j] + 1];
+        }
+        for (int d = 0; d < D; ++d) {
+            start[d + 1] += start[d];
+        }
+        std::vector<int> fill(start.begin(), start.end() - 1);
+        for (size_t j = 0; j < vertices.size(); ++j) {
+            order[fill[domain[j]]++] = vertices[j];
+        }
+        for (int d = 0; d < D; ++d) {
+            cursor[d].next.store(start[d], std::memory_order_relaxed);
+        }
+    }
+
+    // f(v) for the vertices this thread claims; every thread of the team calls it
+    template <typename F>
+    void run(F&& f) {
+        const int D = numa.numDomains();
+        const int home = numa.threadDomainOf(omp_get_thread_num());
+        for (int i = 0; i < D; ++i) {
+            const int d = (home + i) % D;
+            for (;;) {
+                const int lo = cursor[d].next.fetch_add(chunk, std::memory_order_relaxed);
+                if (lo >= start[d + 1]) {
+                    break;
+                }
+                const int hi = std::min(lo + chunk, start[d + 1]);
+                for (int j = lo; j < hi; ++j) {
+                    f(order[j]);
+                }
+            }
+        }
+    }
+
+private:
+    struct alignas(64) Cursor {
+        std::atomic<int> next{0};
+    };
+
+    const NumaLayout& numa;
+    const int chunk;
+    std::vector<int> order;           // the vertices, domain by domain
+    std::vector<int> start;           // group d is order[start[d] .. start[d + 1])
+    std::vector<Cursor> cursor;       // next unclaimed index of each group
+};
+
+
+// Theorem 1.2 Data Structure //
+
+// Graph-side state of Theorem 1.2: Out, its reverse Rev and edge liveness.
+// None of it depends on the source, so one SharedGraph serves every
+// DynamicSSSP tracking a source on the same graph; sources only read it, and
+// it changes only in deleteEdges and insertEdges.
+//
+// Edge ids are positions in Rev.  In(v) is not stored as a structure of its
+// own: its priority order (n - u) is the order of row v of Rev, so rank k of
+// In(v) is edge Rev.offsets[v] + k - 1 and NEXTWITH is a scan of the row
+// against the alive bitmap.  Inserted edges that are not in Rev get ids from
+// Rev.numEdges() on and are appended to a per-vertex overflow list: they take
+// the ranks after In(v), so no rank of an existing edge ever moves and Scan(v)
+// stays valid in every source.
+class SharedGraph {
+public:
+    explicit SharedGraph(const std::vector<std::vector<int>>& adjOut)
+        : SharedGraph(CSRGraph(adjOut)) {}
+
+    // reverse graph: bottom-up BFS levels, In(v), and the ids of all edges
+    explicit SharedGraph(CSRGraph adjOut) : SharedGraph(withReverse(std::move(adjOut))) {}
+
+    // Out together with its reverse adjIn = adjOut.transpose() (rows sorted),
+    // e.g. both built by loadEdgeList, so the transpose is not recomputed
+    SharedGraph(CSRGraph adjOut, CSRGraph adjIn)
+        : SharedGraph(std::make_pair(std::move(adjOut), std::move(adjIn))) {}
+
+    // The graph as save wrote it
+    explicit SharedGraph(snapshot::Reader& in)
+        : n(in.get<int>()), Out(), Rev(), alive()
+    {
+        for (CSRGraph* g : {&Out, &Rev}) {
+            g->n = n;
+            g->offsets = in.getArray<int>();
+            g->targets = in.getArray<int>();
+            g->deleted = in.getArray<uint64_t>();
+            if (n < 0 || g->offsets.size() != static_cast<size_t>(n) + 1 || g->offsets[0] != 0 ||
+                g->targets.size() != static_cast<size_t>(g->offsets[n]) ||
+                !std::is_sorted(g->offsets.begin(), g->offsets.end()) ||
+                (!g->deleted.empty() && g->deleted.size() != (g->targets.size() + 63) / 64)) {
+                in.fail("inconsistent graph");
+            }
+        }
+        Out.allocateTombstones();
+
+        alive = in.getArray<uint64_t>();
+        std::vector<int> ends = in.getArray<int>();
+        edited = in.get<uint8_t>() != 0;
+
+        const int m = Rev.numEdges();
+        const size_t numExtra = ends.size() / 2;
+        if (Out.numEdges() != m || ends.size() % 2 != 0 ||
+            alive.size() != (m + numExtra + 63) / 64) {
+            in.fail("inconsistent edge state");
+        }
+        for (size_t j = 0; j < numExtra; ++j) {
+            int u = ends[2 * j];
+            int v = ends[2 * j + 1];
+            if (u < 0 || u >= n || v < 0 || v >= n) {
+                in.fail("overflow edge out of range");
+            }
+            if (extraIn.empty()) {
+                extraIn.resize(n);
+                extraOut.resize(n);
+            }
+            extraEnds.emplace_back(u, v);
+            extraIn[v].push_back(m + static_cast<int>(j));  // ids grow with rank
+            extraOut[u].push_back(m + static_cast<int>(j));
+        }
+
+        numa = NumaLayout(n, Rev.offsets);
+    }
+
+    // Append the graph side to a snapshot (see the snapshot constructor)
+    void save(snapshot::Writer& out) const {
+        out.put<int>(n);
+        for (const CSRGraph* g : {&Out, &Rev}) {
+            out.putArray(g->offsets);
+            out.putArray(g->targets);
+            out.putArray(g->deleted);
+        }
+        out.putArray(alive);
+
+        std::vector<int> ends;
+        ends.reserve(2 * extraEnds.size());
+        for (auto [u, v] : extraEnds) {
+            ends.push_back(u);
+            ends.push_back(v);
+        }
+        out.putArray(ends);
+        out.put<uint8_t>(edited);
+    }
+
+    int numVertices() const {
+        return n;
+    }
+
+    // vertex ranges per socket (see setNumaPlacement); one domain unless
+    // placement was on when the graph was built
+    const NumaLayout& numaLayout() const {
+        return numa;
+    }
+
+    // Mark the edges of a batch dead (first pass of Algorithm 1, graph side).
+    // Returns the (u, v) that were live until now, each once: the atomic clear
+    // drops repeats within the batch and edges that were already gone.
+    std::vector<std::pair<int,int>> deleteEdges(const std::vector<std::pair<int,int>>& delEdges) {
+        PerfTimer timer(Timer::DeleteEdges);
+        std::vector<std::vector<std::pair<int,int>>> local(omp_get_max_threads());
+
+        const int numDel = static_cast<int>(delEdges.size());
+        #pragma omp parallel if(numDel >= DELETE_PARALLEL_THRESH)
+        {
+            auto& mine = local[omp_get_thread_num()];
+
+            #pragma omp for schedule(static)
+            for (int j = 0; j < numDel; ++j) { // iterate over delete batch
+                auto [u, v] = delEdges[j];
+                if (u < 0 || u >= n || v < 0 || v >= n) continue;
+
+                // If the edge ei does not belong to T, we remove it from the data structure In(v) and Out(v)
+                // by marking it as an invalid edge. This can be done with a single call of the Set operation
+                // per each edge, requiring an O(1) work and depth.
+                int e = Rev.findEdge(v, u);
+                if (e < 0) {
+                    e = findExtraEdge(u, v);
+                }
+                if (e < 0 || !killEdge(e)) {
+                    continue;
+                }
+                if (e < Rev.numEdges()) {
+                    Out.removeEdge(u, v);
+                }
+                mine.emplace_back(u, v);
+            }
+        }
+
+        std::vector<std::pair<int,int>> killed;
+        for (const auto& l : local) {
+            killed.insert(killed.end(), l.begin(), l.end());
+        }
+        edited = edited || !killed.empty();
+        return killed;
+    }
+
+    // Make the edges of a batch live.  An edge that was deleted comes back under
+    // its old id (and rank); any other edge gets a new id at the end of the
+    // overflow list of v.  Returns the (u, v) that were not live until now, each
+    // once.
+    std::vector<std::pair<int,int>> insertEdges(const std::vector<std::pair<int,int>>& insEdges) {
+        PerfTimer timer(Timer::InsertEdges);
+        std::vector<std::vector<std::pair<int,int>>> local(omp_get_max_threads());
+        std::vector<std::vector<std::pair<int,int>>> fresh(omp_get_max_threads());
+
+        // edges of Rev: the atomic set lets one copy of a repeated edge through
+        const int numIns = static_cast<int>(insEdges.size());
+        #pragma omp parallel if(numIns >= DELETE_PARALLEL_THRESH)
+        {
+            auto& mine = local[omp_get_thread_num()];
+            auto& mineFresh = fresh[omp_get_thread_num()];
+
+            #pragma omp for schedule(static)
+            for (int j = 0; j < numIns; ++j) {
+                auto [u, v] = insEdges[j];
+                if (u < 0 || u >= n || v < 0 || v >= n) continue;
+
+                int e = Rev.findEdge(v, u);
+                if (e < 0) {
+                    mineFresh.emplace_back(u, v);
+                } else if (reviveEdge(e)) {
+                    Out.restoreEdge(u, v);
+                    mine.emplace_back(u, v);
+                }
+            }
+        }
+
+        std::vector<std::pair<int,int>> added;
+        for (const auto& l : local) {
+            added.insert(added.end(), l.begin(), l.end());
+        }
+
+        // overflow edges: the lists grow, so this part is serial
+        for (const auto& l : fresh) {
+            for (auto [u, v] : l) {
+                int e = findExtraEdge(u, v);
+                if (e < 0) {
+                    addExtraEdge(u, v);
+                } else if (!reviveEdge(e)) {
+                    continue;
+                }
+                added.emplace_back(u, v);
+            }
+        }
+        edited = edited || !added.empty();
+        return added;
+    }
+
+    // false once an edge has been deleted or inserted
+    bool pristine() const {
+        return !edited;
+    }
+
+private:
+    friend class DynamicSSSP;
+
+    // Out and Rev = Out.transpose() in hand: the rest of the graph side
+    explicit SharedGraph(std::pair<CSRGraph, CSRGraph>&& outRev)
+        : n(outRev.first.numVertices()), Out(std::move(outRev.first)), Rev(std::move(outRev.second)),
+          alive()
+    {
+        // One id per (u, v): deleteEdges and insertEdges look an edge up by its
+        // first copy in Rev, so a repeated edge could never die.  Out and Rev
+        // hold the same multiset of pairs, so they dedup to transposes.
+        if (Out.hasRepeatedTargets() || Rev.hasRepeatedTargets()) {
+            Out.compactRows();
+            Rev.compactRows();
+        }
+        if (Rev.numVertices() != n || Rev.numEdges() != Out.numEdges()) {
+            throw std::logic_error("SharedGraph: reverse graph does not match Out");
+        }
+        Out.allocateTombstones();
+
+        numa = NumaLayout(n, Rev.offsets);
+
+        // Initialize alive-edge bitmap: every edge id is live
+        int m = Rev.numEdges();
+        alive.assign((m + 63) / 64, ~uint64_t(0));
+        if (m & 63) {
+            alive.back() = (uint64_t(1) << (m & 63)) - 1;
+        }
+    }
+
+    int n;
+    CSRGraph Out;
+    CSRGraph Rev;                       // reverse of Out; edge ids are positions in Rev
+    std::vector<uint64_t> alive;        // liveness bit per edge id, cleared atomically
+
+    // Overflow edges (ids Rev.numEdges() + j), allocated on the first one
+    std::vector<std::pair<int,int>> extraEnds;   // (u, v) of overflow edge j
+    std::vector<std::vector<int>> extraIn;       // extraIn[v]: ids, in rank order after In(v)
+    std::vector<std::vector<int>> extraOut;      // extraOut[u]: ids of overflow edges out of u
+    bool edited = false;
+    NumaLayout numa;                    // per-socket vertex ranges, shared by every source
+
+    static std::pair<CSRGraph, CSRGraph> withReverse(CSRGraph out) {
+        CSRGraph rev = out.transpose();
+        return {std::move(out), std::move(rev)};
+    }
+
+    // batchDelete marks at least this many edges dead before opening a team
+    static constexpr int DELETE_PARALLEL_THRESH = 1 << 12;
+
+    bool isAlive(int e) const {
+        return (__atomic_load_n(&alive[e >> 6], __ATOMIC_RELAXED) >> (e & 63)) & 1;
+    }
+
+    // clear the liveness bit of edge e; false if it was already dead
+    bool killEdge(int e) {
+        uint64_t bit = uint64_t(1) << (e & 63);
+        return __atomic_fetch_and(&alive[e >> 6], ~bit, __ATOMIC_RELAXED) & bit;
+    }
+
+    // set the liveness bit of edge e; false if it was already live
+    bool reviveEdge(int e) {
+        uint64_t bit = uint64_t(1) << (e & 63);
+        return !(__atomic_fetch_or(&alive[e >> 6], bit, __ATOMIC_RELAXED) & bit);
+    }
+
+    // id of the overflow edge (u, v), live or dead, or -1
+    int findExtraEdge(int u, int v) const {
+        if (extraIn.empty()) {
+            return -1;
+        }
+        for (int e : extraIn[v]) {
+            if (extraEnds[e - Rev.numEdges()].first == u) {
+                return e;
+            }
+        }
+        return -1;
+    }
+
+    // new live overflow edge (u, v), at the last rank of v
+    void addExtraEdge(int u, int v) {
+        if (extraIn.empty()) {
+            extraIn.resize(n);
+            extraOut.resize(n);
+        }
+        const int e = Rev.numEdges() + static_cast<int>(extraEnds.size());
+        extraEnds.emplace_back(u, v);
+        extraIn[v].push_back(e);
+        extraOut[u].push_back(e);
+        if ((e >> 6) >= static_cast<int>(alive.size())) {
+            alive.push_back(0);
+        }
+        alive[e >> 6] |= uint64_t(1) << (e & 63);
+    }
+
+    // ranks of In(v) held by row v of Rev; the overflow ranks follow
+    int rowDegree(int v) const {
+        return Rev.offsets[v + 1] - Rev.offsets[v];
+    }
+
+    // |In(v)| plus the overflow in-edges of v
+    int inDegree(int v) const {
+        return rowDegree(v) + (extraIn.empty() ? 0 : static_cast<int>(extraIn[v].size()));
+    }
+
+    // u of the in-edge (u, v) at rank k, 1 <= k <= inDegree(v)
+    int inNeighbor(int v, int k) const {
+        const int sz = rowDegree(v);
+        if (k <= sz) {
+            return Rev.targets[Rev.offsets[v] + k - 1];
+        }
+        return extraEnds[extraIn[v][k - sz - 1] - Rev.numEdges()].first;
+    }
+
+    // f(w) for every live out-neighbor w of u, overflow edges included
+    template <typename F>
+    void forEachOutNeighbor(int u, F&& f) const {
+        Out.forEachNeighbor(u, f);
+        if (!extraOut.empty()) {
+            for (int e : extraOut[u]) {
+                if (isAlive(e)) {
+                    f(extraEnds[e - Rev.numEdges()].second);
+                }
+            }
+        }
+    }
 
-std::vector<int> bfs_array(const std::vector<std::vector<int>>& adj, int s, int L) {
-    int n = adj.size();
+    // Starting from rank k of row v, skip dead in-edges a bitmap word at a
+    // time; returns rowDegree(v) + 1 if none is live.
+    int firstLiveRank(int v, int k) const {
+        const int lo = Rev.offsets[v];
+        const int hi = Rev.offsets[v + 1];
+
+        for (int e = lo + k - 1; e < hi; e = (e | 63) + 1) {
+            uint64_t word = __atomic_load_n(&alive[e >> 6], __ATOMIC_RELAXED) &
+                            (~uint64_t(0) << (e & 63));
+            if (word) {
+                int first = (e & ~63) + __builtin_ctzll(word);
+                return first < hi ? first - lo + 1 : hi - lo + 1;
+            }
+        }
+        return hi - lo + 1;
+    }
 
-    std::vector<int> dist(n, L + 1);
+    // NEXTWITH(k) on In(v) for "in-edge (u, v) alive and dist[u] == target".
+    // The candidates u of row v are a contiguous slice of Rev.targets, tested
+    // by the gather kernel; a hit on a dead edge resumes after it.  Ranks past
+    // the row are the overflow in-edges, scanned in order.  Returns
+    // inDegree(v) + 1 if no rank from k on qualifies.
+    int nextParent(int v, int k, const int* dist, int target) const {
+        const int sz = rowDegree(v);
+        if (k <= sz) {
+            k = nextParentRange(v, k, sz, dist, target);
+            if (k <= sz) {
+                return k;
+            }
+        }
+        return nextParentExtra(v, k, dist, target);
+    }
 
-    std::vector<std::set<int>> levels(L+1);
+    // nextParent for a long scan, as tasks of the current team (call it from
+    // inside a parallel region).  Like NEXTWITH, the ranks from k are taken in
+    // windows of doubling length, the first one grain ranks long and scanned
+    // in place; a longer window is cut into grain-rank ranges, one task each,
+    // scanned by nextParentRange.  Ranges past a hit already found return at
+    // once, and the first window with a hit decides.
+    int nextParentTasks(int v, int k, const int* dist, int target, int grain) const {
+        const int sz = rowDegree(v);
+        long long len = grain;
+        for (int p = std::max(k, 1); p <= sz; ) {
+            const int end = static_cast<int>(std::min<long long>(sz, p + len - 1));
+            int best = end + 1;
+            if (end - p + 1 <= grain) {
+                best = nextParentRange(v, p, end, dist, target);
+            } else {
+                const int ranges = (end - p) / grain + 1;
+                #pragma omp taskloop grainsize(1) shared(best)
+                for (int r = 0; r < ranges; ++r) {
+                    const int lo = p + r * grain;
+                    if (lo > __atomic_load_n(&best, __ATOMIC_RELAXED)) {
+                        continue;
+                    }
+                    const int hi = std::min(end, lo + grain - 1);
+                    const int hit = nextParentRange(v, lo, hi, dist, target);
+                    if (hit <= hi) {
+                        int seen = __atomic_load_n(&best, __ATOMIC_RELAXED);
+                        while (hit < seen && !__atomic_compare_exchange_n(
+                                   &best, &seen, hit, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                        }
+                    }
+                }
+            }
+            if (best <= end) {
+                return best;
+            }
+            p = end + 1;
+            len *= 2;
+        }
+        return nextParentExtra(v, std::max(k, sz + 1), dist, target);
+    }
 
-    // Initialize
-    dist[s] = 0;
-    levels[0].insert(s);
+    // the overflow ranks of nextParent, from k > rowDegree(v) on
+    int nextParentExtra(int v, int k, const int* dist, int target) const {
+        const int sz = rowDegree(v);
+        if (extraIn.empty()) {
+            return sz + 1;
+        }
 
-    // BFS by levels up to depth L
-    for (int i = 0; i < L; ++i) {
-        const std::set<int>& curr = levels[i];
-        std::set<int>& next = levels[i + 1];
+        const std::vector<int>& extra = extraIn[v];
+        const int numExtra = static_cast<int>(extra.size());
+        for (int j = std::max(k, sz + 1) - sz - 1; j < numExtra; ++j) {
+            const int e = extra[j];
+            if (isAlive(e) && dist[extraEnds[e - Rev.numEdges()].first] == target) {
+                return sz + 1 + j;
+            }
+        }
+        return sz + numExtra + 1;
+    }
 
-        if (curr.empty()) {
-            break;
+    // nextParent over ranks [k, hi] of row v (hi <= rowDegree(v)); hi + 1 if
+    // none qualifies
+    int nextParentRange(int v, int k, int hi, const int* dist, int target) const {
+        k = firstLiveRank(v, k);
+        if (k > hi) {
+            return hi + 1;
         }
 
-        // within level we parallelize expanding the fringe (conceptually)
-        for (int v : curr) {  // iterate over nodes
-            for (int u : adj[v]) {  // iterate over out-neighbors
-                if (dist[u] > i + 1) {
-                    dist[u] = i + 1;
-                    next.insert(u);
-                }
+        const int lo = Rev.offsets[v];
+        const int* row = Rev.targets.data() + lo;  // row[r - 1] is rank r
+        while (k <= hi) {
+            int start = k;
+            k += firstGatherMatch(row + k - 1, hi - k + 1, dist, target);
+            PerfCounters::add(Counter::GatherRanks, std::min(k, hi) - start + 1);
+            if (k > hi || isAlive(lo + k - 1)) {
+                return std::min(k, hi + 1);
             }
+            k = firstLiveRank(v, k + 1);
         }
+        return hi + 1;
     }
-    return dist;
-}
-
+};
 
-// Theorem 1.2 Data Structure //
 
+// Per-source state of Theorem 1.2 (Dist, Scan, Parent, T) over a SharedGraph.
 class DynamicSSSP {
 public:
+    // Cost of one repair (one deletion batch) or relax (one insertion batch),
+    // for benchmarking
+    struct BatchStats {
+        int killed = 0;               // edges that died in the batch
+        int treeEdges = 0;            // ... of which were edges of T
+        int inserted = 0;             // edges that became live in the batch
+        std::vector<int> phaseU;      // |U| at the start of each phase run (relax: lowered
+                                      // vertices per BFS level)
+        long long probes = 0;         // NEXTWITH calls on In(v)
+        long long ranksScanned = 0;   // In(v) ranks those calls passed over
+        long long enqueued = 0;       // vertices moved into U, over all phases (relax: lowered)
+        double seconds = 0;           // wall time of repair / relax
+
+        // scanned ranks + probes + enqueued vertices
+        long long work() const { return ranksScanned + probes + enqueued; }
+    };
+
     DynamicSSSP(const std::vector<std::vector<int>>& adjOut, int s, int L)
-        : n(adjOut.size()), L(L), s(s), Dist(),
-          Out(adjOut), In(),
-          Scan(), Tv(), Parent(),
-          alive()
-    {
-        // 1) Dist via Lemma 3.2:
-        Dist = bfs_array(Out, s, L);
+        : DynamicSSSP(std::make_shared<SharedGraph>(adjOut), s, L) {}
+
+    DynamicSSSP(CSRGraph adjOut, int s, int L)
+        : DynamicSSSP(std::make_shared<SharedGraph>(std::move(adjOut)), s, L) {}
 
-        // 2) Build In(v) as PriorityStructure using in-neighbors:
-        int maxPriority = n;  // priorities in [1..n]
-        std::vector<std::vector<int>> adjOutInv(n);
-        for (int u = 0; u < n; u++) {
-            for (int v : adjOut[u]) {
-                adjOutInv[v].push_back(u);
+    // a source on an existing graph: Out, Rev and liveness are shared, not copied
+    DynamicSSSP(std::shared_ptr<SharedGraph> graph, int s, int L)
+        : n(graph->numVertices()), L(L), s(s), Dist(),
+          G(std::move(graph)),
+          Scan(), Parent(), Tv()
+    {
+        // 1) Dist via Lemma 3.2 (direction-optimizing).  Bottom-up levels read
+        //    Rev, which keeps dead edges and lacks overflow ones, so a graph that
+        //    has been edited is searched top-down over its live edges.
+        {
+            PerfTimer timer(Timer::InitBFS);
+            std::vector<int> dist;
+            if (G->pristine()) {
+                dist = bfs_array(G->Out, G->Rev, s, L, &bfsDirections);
+            } else {
+                const SharedGraph& g = *G;
+                dist = bfs_frontier(n, s, L, [&](int v, const auto& f) {
+                    g.forEachOutNeighbor(v, f);
+                });
             }
+            G->numa.place(Dist, std::move(dist));
         }
 
-        In.reserve(n);
-        for (int v = 0; v < n; v++) {
-            std::vector<std::pair<int,int>> elems;
-            elems.reserve(adjOutInv[v].size());
-            for (int u : adjOutInv[v]) {
-                // value = u, priority = u+1 (must be in [1..maxPriority])
-                elems.emplace_back(u, u+1);
-            }
-            In.emplace_back(maxPriority);
-            In[v].initialize(elems);
+        // 2) In(v) (the rows of Rev) and 3) the alive-edge bitmap belong to the shared graph
+
+        // 4) Initialize Scan, Parent, T to form the initial BFS tree T
+        initScanAndTree();
+
+        const NumaLayout& numa = G->numa;
+        numa.fill(queued, n, uint8_t(0));
+        numa.fill(parentDeleted, n, uint8_t(0));
+        orphans.assign(L + 2, std::vector<int>());
+
+        // 5) Both reader snapshots start as the initial tree
+        for (Snapshot& S : snap) {
+            numa.copy(S.dist, Dist);
+            numa.copy(S.parent, Parent);
         }
+    }
 
-        // 3) Initialize alive-edge set
-        for (int u = 0; u < n; ++u) {
-            for (int v : Out[u]) {
-                alive.insert(encodeEdge(u, v));
+    // a source read back from a snapshot (the next item of in) on its graph:
+    // no BFS and no rescans, Dist, Scan, Parent and T are taken as saved
+    DynamicSSSP(std::shared_ptr<SharedGraph> graph, snapshot::Reader& in)
+        : n(graph->numVertices()), L(0), s(0), Dist(),
+          G(std::move(graph)),
+          Scan(), Parent(), Tv()
+    {
+        s = in.get<int>();
+        L = in.get<int>();
+        epochCount.store(in.get<unsigned long>(), std::memory_order_relaxed);
+        const NumaLayout& numa = G->numa;
+        numa.place(Dist, in.getArray<int>());
+        numa.place(Parent, in.getArray<int>());
+        numa.place(Scan, in.getArray<int>());
+        std::vector<int> tvOffsets = in.getArray<int>();
+        std::vector<int> tvTargets = in.getArray<int>();
+        std::vector<uint8_t> dirs = in.getArray<uint8_t>();
+
+        const size_t sz = static_cast<size_t>(n);
+        if (s < 0 || s >= n || L < 0 || Dist.size() != sz || Parent.size() != sz ||
+            Scan.size() != sz || tvOffsets.size() != sz + 1 || tvOffsets[0] != 0 ||
+            !std::is_sorted(tvOffsets.begin(), tvOffsets.end()) ||
+            tvTargets.size() != static_cast<size_t>(tvOffsets[n])) {
+            in.fail("inconsistent source state");
+        }
+
+        Tv.resize(n);
+        auto loadChildren = [&](int v) {
+            Tv[v].assign(tvTargets.begin() + tvOffsets[v], tvTargets.begin() + tvOffsets[v + 1]);
+        };
+        if (numa.active()) {
+            numa.forEachOwned(loadChildren, 1024);
+        } else {
+            #pragma omp parallel for schedule(dynamic, 1024)
+            for (int v = 0; v < n; ++v) {
+                loadChildren(v);
             }
         }
+        for (uint8_t d : dirs) {
+            bfsDirections.push_back(static_cast<BFSDirection>(d));
+        }
 
-        // 4) Initialize Scan, Parent, T to form the initial BFS tree T
-        initScanAndTree();
+        numa.fill(queued, n, uint8_t(0));
+        numa.fill(parentDeleted, n, uint8_t(0));
+        orphans.assign(L + 2, std::vector<int>());
+        for (Snapshot& S : snap) {
+            numa.copy(S.dist, Dist);
+            numa.copy(S.parent, Parent);
+        }
     }
 
+    // Write the graph and this source to path; like batchDelete, not to be
+    // called while a batch runs.  Readers may keep going.
+    void save(const std::string& path) const {
+        snapshot::Writer out(path);
+        G->save(out);
+        out.put<int>(1);
+        saveSource(out);
+        out.finish();
+    }
 
-    // page 10 - Algorithm 1
-    void batchDelete(const std::vector<std::pair<int,int>>& delEdges) {
-        std::vector<bool> parentDeleted(n, false);
-        std::vector<std::pair<int,int>> treeEdges;   // edges from T whose parent is removed
+    // A DynamicSSSP as save left it.  The file is mapped and every array is
+    // copied out in parallel before this returns; nothing is rebuilt.
+    static std::unique_ptr<DynamicSSSP> load(const std::string& path) {
+        snapshot::Reader in(path);
+        auto graph = std::make_shared<SharedGraph>(in);
+        if (in.get<int>() != 1) {
+            in.fail("expected a single source");
+        }
+        return std::make_unique<DynamicSSSP>(std::move(graph), in);
+    }
 
-        // First pass
-        for (auto [u, v] : delEdges) { // iterate over delete batch
-            if (u < 0 || u >= n || v < 0 || v >= n) continue;
+    // Append this source to a snapshot (see the snapshot constructor)
+    void saveSource(snapshot::Writer& out) const {
+        out.put<int>(s);
+        out.put<int>(L);
+        out.put<unsigned long>(epochCount.load(std::memory_order_acquire));
+        out.putArray(Dist);
+        out.putArray(Parent);
+        out.putArray(Scan);
+
+        std::vector<int> tvOffsets(n + 1, 0);
+        for (int v = 0; v < n; ++v) {
+            tvOffsets[v + 1] = tvOffsets[v] + static_cast<int>(Tv[v].size());
+        }
+        std::vector<int> tvTargets(tvOffsets[n]);
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int v = 0; v < n; ++v) {
+            std::copy(Tv[v].begin(), Tv[v].end(), tvTargets.begin() + tvOffsets[v]);
+        }
+        out.putArray(tvOffsets);
+        out.putArray(tvTargets);
+
+        std::vector<uint8_t> dirs;
+        for (BFSDirection d : bfsDirections) {
+            dirs.push_back(static_cast<uint8_t>(d));
+        }
+        out.putArray(dirs);
+    }
 
-            long long key = encodeEdge(u, v);
-            auto it = alive.find(key);
-            if (it == alive.end()) {
-                continue;
-            }
 
-            alive.erase(it); // tell the data structure this edge is dead
-            auto &outList = Out[u];
-            outList.erase(std::remove(outList.begin(), outList.end(), v), outList.end());
+    // page 10 - Algorithm 1
+    // Only for a graph this source does not share: other sources on G would
+    // miss the deletions.  Shared graphs go through MultiSourceSSSP::batchDelete.
+    void batchDelete(const std::vector<std::pair<int,int>>& delEdges) {
+        repair(G->deleteEdges(delEdges));
+    }
 
-            // If the edge ei does not belong to T, we remove it from the data structure In(v) and Out(v)
-            // by marking it as an invalid edge. This can be done with a single call of the Set operation
-            // per each edge, requiring an O(1) work and depth. Hence, we are left only with edges from T.
+    // Algorithm 1 for edges that G->deleteEdges has just marked dead
+    // (its return value); the graph side of the first pass is already done.
+    void repair(const std::vector<std::pair<int,int>>& killed) {
+        const double start = omp_get_wtime();
+        stats = BatchStats();
+        stats.killed = static_cast<int>(killed.size());
+        long long probes = 0;
+        long long scanned = 0;
+        PerfCounters::add(Counter::RepairBatches);
 
-            if (Parent[v] == u) { // parent deleted (tree edge)
-                treeEdges.emplace_back(u, v);
-                parentDeleted[v] = true;
-                // Remove v from children list Tv[u]
-                auto &kids = Tv[u];
-                kids.erase(std::remove(kids.begin(), kids.end(), v), kids.end());
-                Parent[v] = -1;
+        std::vector<std::pair<int,int>> treeEdges;   // edges from T whose parent is removed
+        int lastBucket = 0;                          // largest d with orphans[d] non-empty
+
+        // Per-thread (parent, child) buffers: deleted tree edges in the first
+        // pass, new tree edges afterwards.
+        std::vector<std::vector<std::pair<int,int>>> links(omp_get_max_threads());
+
+        // First pass: we are left only with edges from T.
+        std::optional<PerfTimer> timer(std::in_place, Timer::FirstPass);
+        const int numKilled = static_cast<int>(killed.size());
+        #pragma omp parallel if(numKilled >= SharedGraph::DELETE_PARALLEL_THRESH)
+        {
+            auto& myLinks = links[omp_get_thread_num()];
+
+            #pragma omp for schedule(static)
+            for (int j = 0; j < numKilled; ++j) {
+                auto [u, v] = killed[j];
+                if (Parent[v] == u) { // parent deleted (tree edge)
+                    myLinks.emplace_back(u, v);
+                }
             }
         }
 
-        // Second Pass
+        for (auto& l : links) {
+            treeEdges.insert(treeEdges.end(), l.begin(), l.end());
+            l.clear();
+        }
         for (auto [u, v] : treeEdges) {
+            dirty.push_back(v);
+            parentDeleted[v] = 1;
+            orphans[Dist[v]].push_back(v);
+            lastBucket = std::max(lastBucket, Dist[v]);
+            Parent[v] = -1;
+        }
+        detachChildren(treeEdges);  // Remove v from children list Tv[u]
+        stats.treeEdges = static_cast<int>(treeEdges.size());
+
+        // From here on Dist and alive only change between phases, so the rescans
+        // of different vertices are independent.  New (parent, child) links go to
+        // per-thread buffers and are attached to Tv after each parallel loop.
+
+        // Under NUMA placement the rescan loops below hand out vertices by owner
+        const NumaLayout& numa = G->numa;
+        std::optional<OwnerQueue> owners;
+
+        // Rescans split into tasks (see SPLIT_RANKS) may run on any thread:
+        // they count here, and push to the buffers of the thread running them.
+        long long splitProbes = 0;
+        long long splitScanned = 0;
+
+        // Line 7 for v: rescan from Scan(v) for an alive in-edge from Dist[v] - 1.
+        // Returns false if In(v) is exhausted.
+        auto rescanFrom = [&](int v, bool split, long long& myProbes, long long& myScanned) {
+            const SharedGraph& g = *G;
+            int k = Scan[v];
+            Scan[v] = split ? g.nextParentTasks(v, k, Dist.data(), Dist[v] - 1, STEAL_GRAIN)
+                            : g.nextParent(v, k, Dist.data(), Dist[v] - 1);
+            const long long passed = ranksPassed(k, Scan[v], g.inDegree(v));
+            if (split) {
+                PerfCounters::add(Counter::SplitRescans);
+                __atomic_fetch_add(&splitProbes, 1, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&splitScanned, passed, __ATOMIC_RELAXED);
+            } else {
+                ++myProbes;
+                myScanned += passed;
+            }
+            return Scan[v] != g.inDegree(v) + 1;
+        };
 
-            // predicate for NextWith
-            auto predicate = [this, v](const int& w) -> bool {
-                if (Dist[w] != Dist[v] - 1) return false;
-                long long key = encodeEdge(w, v);
-                return alive.find(key) != alive.end();
+        // Second Pass
+        timer.emplace(Timer::SecondPass);
+        const int numTree = static_cast<int>(treeEdges.size());
+        const bool treeTeam = numTree >= PHASE_PARALLEL_THRESH ||
+            std::any_of(treeEdges.begin(), treeEdges.end(), [&](const auto& e) { return heavyScan(e.second); });
+        if (numa.active() && numTree >= PHASE_PARALLEL_THRESH) {
+            std::vector<int> children(numTree);
+            for (int j = 0; j < numTree; ++j) {
+                children[j] = treeEdges[j].second;
+            }
+            owners.emplace(numa, children, 16);
+        }
+        #pragma omp parallel if(treeTeam) reduction(+:probes, scanned)
+        {
+            auto reparent = [&](int v, bool split) {
+                if (rescanFrom(v, split, probes, scanned)) {
+                    int w = G->inNeighbor(v, Scan[v]);
+                    Parent[v] = w;
+                    links[omp_get_thread_num()].emplace_back(w, v);
+                    parentDeleted[v] = 0;
+                    PerfCounters::add(Counter::Reparented);
+                }
+            };
+            // hubs become tasks, picked up by idle threads at the closing barrier
+            auto dispatch = [&](int v) {
+                if (omp_get_num_threads() > 1 && heavyScan(v)) {
+                    #pragma omp task firstprivate(v)
+                    reparent(v, true);
+                } else {
+                    reparent(v, false);
+                }
             };
 
-            Scan[v] = In[v].nextWith(Scan[v], predicate);
-
-            if (Scan[v] != In[v].size()+1) {
-                int w = In[v].query(Scan[v]);
-                Parent[v] = w;
-                Tv[w].push_back(v);
-                parentDeleted[v] = false;
+            if (owners) {
+                owners->run(dispatch);
+            } else {
+                #pragma omp for schedule(dynamic, 16)
+                for (int j = 0; j < numTree; ++j) {
+                    dispatch(treeEdges[j].second);
+                }
             }
         }
+        owners.reset();
+        attachChildren(links);
+        timer.reset();
 
-        std::unordered_set<int> U;  // Algorithm 1 line 3
+        std::vector<int> U;  // Algorithm 1 line 3
+        std::vector<int> Unew;
+        FrontierBuffers buf;
 
 
         // ---- Phases i = 0..L (Algorithm 1 lines 4–15) ----
@@ -151,60 +1640,373 @@ public:
         // Invariants:  any vertex whose true distance is AT MOST i is either in U or already resolved
         //              U contains only elements of distance at least i
         //              Every element of U has its distance marked as i  (in the ideal version)
+        // Since every v in U sits at Dist i and its new parent at Dist i-1, no parent
+        // found in phase i is itself in U: deferring the Tv appends changes nothing.
         for (int i = 0; i <= L; i++) {
-            std::unordered_set<int> Unew;
-
-            // parallel loop line 6-11
-            for (int v : U) {
-
-                // predicate for NextWith
-                auto predicate = [this, v](const int& w) -> bool {
-                    if (Dist[w] != Dist[v] - 1) return false;
-                    long long key = encodeEdge(w, v);
-                    return alive.find(key) != alive.end();
-                };
+            if (U.empty() && i + 1 > lastBucket) {
+                break;  // nothing left to resolve: later phases are no-ops
+            }
 
-                // Line 7: rescan from current Scan(v)
-                Scan[v] = In[v].nextWith(Scan[v], predicate);
+            const int numU = static_cast<int>(U.size());
+            std::vector<int>& bucket = orphans[i + 1];
+            const int numBucket = static_cast<int>(bucket.size());
+            stats.phaseU.push_back(numU);
+            PerfCounters::add(Counter::RepairPhases);
+            PerfCounters::addPhaseU(i, numU);
+            timer.emplace(Timer::Rescan);
+            const bool phaseTeam = numU + numBucket >= PHASE_PARALLEL_THRESH ||
+                std::any_of(U.begin(), U.end(), [&](int v) { return heavy(v); });
+            if (numa.active() && numU >= PHASE_PARALLEL_THRESH) {
+                owners.emplace(numa, U, 16);
+            }
 
-                if (Scan[v] == In[v].size() + 1) {
-                    // Line 9
-                    Scan[v] = 1;
+            #pragma omp parallel if(phaseTeam) reduction(+:probes, scanned)
+            {
+                buf.local[omp_get_thread_num()].clear();
 
-                    // Line 10
-                    Unew.insert(v);
+                // add x to Unew once; queued[x] is the dedup flag
+                auto enqueue = [&](int x) {
+                    if (__atomic_exchange_n(&queued[x], 1, __ATOMIC_RELAXED) == 0) {
+                        buf.local[omp_get_thread_num()].push_back(x);
+                        PerfCounters::add(Counter::PushedNext);
+                    }
+                };
 
-                    // Line 11
-                    for (int child : Tv[v]) {
-                        Unew.insert(child);
+                // parallel loop line 6-11
+                auto rescan = [&](int v, bool split) {
+                    if (!rescanFrom(v, split, probes, scanned)) {
+                        // Line 9
+                        Scan[v] = 1;
+
+                        // Line 10
+                        enqueue(v);
+
+                        // Line 11: a large fan-out is cut into tasks as well
+                        std::vector<int>& kids = Tv[v];
+                        const int numKids = static_cast<int>(kids.size());
+                        if (numKids >= SPLIT_CHILDREN && omp_get_num_threads() > 1) {
+                            PerfCounters::add(Counter::SplitFanouts);
+                            #pragma omp taskloop grainsize(STEAL_GRAIN)
+                            for (int j = 0; j < numKids; ++j) {
+                                enqueue(kids[j]);
+                            }
+                        } else {
+                            for (int child : kids) {
+                                enqueue(child);
+                            }
+                        }
+                        Tv[v] = std::vector<int>();
+
+                    } else {
+                        int w = G->inNeighbor(v, Scan[v]);
+                        Parent[v] = w;
+                        links[omp_get_thread_num()].emplace_back(w, v);
+                        PerfCounters::add(Counter::Reparented);
+                    }
+                };
+                // hubs become tasks, picked up by idle threads at the barrier
+                // that closes the bucket loop below (a large fan-out alone
+                // splits inside rescan)
+                auto dispatch = [&](int v) {
+                    if (omp_get_num_threads() > 1 && heavyScan(v)) {
+                        #pragma omp task firstprivate(v)
+                        rescan(v, true);
+                    } else {
+                        rescan(v, false);
                     }
-                    Tv[v] = std::vector<int>();
+                };
 
+                if (owners) {
+                    owners->run(dispatch);
                 } else {
-                    int w = In[v].query(Scan[v]);
-                    Parent[v] = w;
-                    Tv[w].push_back(v);
+                    #pragma omp for schedule(dynamic, 16) nowait
+                    for (int j = 0; j < numU; ++j) {
+                        dispatch(U[j]);
+                    }
+                }
+
+                // line 12: only vertices orphaned at distance i+1 can qualify;
+                // each is recorded in exactly one bucket, so its flag is reset here
+                #pragma omp for schedule(static)
+                for (int j = 0; j < numBucket; ++j) {
+                    int v = bucket[j];
+                    if (Dist[v] == i + 1 && parentDeleted[v]) {
+                        enqueue(v);
+                    }  // sufficient for decremental, can simply throw away nodes after they get too far.
+                    parentDeleted[v] = 0;
                 }
-            }
 
-            // line 12
-            for (int v=0; v<n; v++) {  // Linear complexity... corrct impl??
-                if (Dist[v] == i + 1 && parentDeleted[v]) {
-                    Unew.insert(v);
-                }  // sufficient for decremental, can simply throw away nodes after they get too far.
+                buf.concat(Unew);
             }
+            attachChildren(links);
+            bucket.clear();
+            owners.reset();
 
             // line 13
+            timer.emplace(Timer::Advance);
             U.swap(Unew);
 
-            // parallel loop line 14-15
-            for (int v : U) {
+            // parallel loop line 14-15; past L a vertex has no parent (its
+            // children were enqueued without a rescan, so Parent still names v)
+            const int numNext = static_cast<int>(U.size());
+            #pragma omp parallel for if(numNext >= PHASE_PARALLEL_THRESH)
+            for (int j = 0; j < numNext; ++j) {
+                int v = U[j];
                 Dist[v] = i + 1;
+                queued[v] = 0;
+                if (i == L) {
+                    Parent[v] = -1;
+                }
+            }
+            dirty.insert(dirty.end(), U.begin(), U.end());
+            stats.enqueued += numNext;
+        }
+
+        timer.emplace(Timer::Publish);
+        publishSnapshot();
+        timer.reset();
+
+        stats.probes = probes + splitProbes;
+        stats.ranksScanned = scanned + splitScanned;
+        stats.seconds = omp_get_wtime() - start;
+    }
+
+    // Fully dynamic mode: insert a batch of edges (same restriction as batchDelete)
+    void batchInsert(const std::vector<std::pair<int,int>>& insEdges) {
+        relax(G->insertEdges(insEdges));
+    }
+
+    // Update Dist, Scan, Parent and T for edges that G->insertEdges has just
+    // made live (its return value).  Distances only drop:
+    //   1) bounded BFS: an edge (u, v) with Dist[u] + 1 < Dist[v] lowers v to
+    //      Dist[u] + 1, and every lowered x lowers its out-neighbors past
+    //      Dist[x] + 1, level by level up to L;
+    //   2) a vertex may now have a parent at a rank below Scan(v) if it was
+    //      lowered, or is the head of a new edge or an out-neighbor of a lowered
+    //      vertex at the next level.  Those vertices rescan In(v) from rank 1,
+    //      so that no rank before Scan(v) holds a parent, as repair assumes.
+    // The cost is the out-degree of the lowered vertices plus one rescan each
+    // for the candidates of 2).
+    void relax(const std::vector<std::pair<int,int>>& added) {
+        const double start = omp_get_wtime();
+        stats = BatchStats();
+        stats.inserted = static_cast<int>(added.size());
+        long long probes = 0;
+        long long scanned = 0;
+        PerfCounters::add(Counter::InsertBatches);
+        const SharedGraph& g = *G;
+
+        // (new distance, v) for each endpoint an inserted edge lowers; the
+        // candidates of 2) are collected with the queued flag as dedup
+        std::vector<std::pair<int,int>> seeds;
+        std::vector<int> rescan;
+        for (auto [u, v] : added) {
+            if (Dist[u] < L && Dist[u] + 1 < Dist[v]) {
+                seeds.emplace_back(Dist[u] + 1, v);
+            } else if (Dist[u] < L && Dist[u] + 1 == Dist[v] && !queued[v]) {
+                queued[v] = 1;
+                rescan.push_back(v);
+            }
+        }
+        std::sort(seeds.begin(), seeds.end());
+
+        // 1) levels d = first seed .. L; frontier holds the vertices lowered to d.
+        //    Past L, Parent may be stale and v may or may not be in its Tv list,
+        //    so a vertex coming back is unlinked from it unconditionally.
+        std::optional<PerfTimer> timer(std::in_place, Timer::Lower);
+        std::vector<int> frontier;
+        std::vector<int> next;
+        std::vector<int> lowered;
+        std::vector<std::vector<std::pair<int,int>>> unlinks(omp_get_max_threads());
+        FrontierBuffers buf;
+        FrontierBuffers touched;
+        size_t nextSeed = 0;
+        for (int d = seeds.empty() ? L + 1 : seeds[0].first; d <= L; ++d) {
+            for (; nextSeed < seeds.size() && seeds[nextSeed].first == d; ++nextSeed) {
+                int v = seeds[nextSeed].second;
+                if (Dist[v] > d) {
+                    if (Dist[v] > L && Parent[v] >= 0) {
+                        unlinks[0].emplace_back(Parent[v], v);
+                        Parent[v] = -1;
+                    }
+                    Dist[v] = d;
+                    frontier.push_back(v);
+                }
+            }
+            if (frontier.empty()) {
+                if (nextSeed == seeds.size()) {
+                    break;
+                }
+                d = seeds[nextSeed].first - 1;
+                continue;
+            }
+            stats.phaseU.push_back(static_cast<int>(frontier.size()));
+            lowered.insert(lowered.end(), frontier.begin(), frontier.end());
+
+            if (d == L) {
+                break;  // past L nothing is tracked
+            }
+
+            // CAS Dist[y] down to d + 1: each y enters exactly one thread's buffer
+            const int numF = static_cast<int>(frontier.size());
+            #pragma omp parallel if(numF >= PHASE_PARALLEL_THRESH)
+            {
+                int t = omp_get_thread_num();
+                auto& mine = buf.local[t];
+                auto& mineTouched = touched.local[t];
+                auto& myUnlinks = unlinks[t];
+                mine.clear();
+
+                #pragma omp for schedule(dynamic, 16)
+                for (int j = 0; j < numF; ++j) {
+                    g.forEachOutNeighbor(frontier[j], [&](int y) {
+                        int cur = __atomic_load_n(&Dist[y], __ATOMIC_RELAXED);
+                        while (cur > d + 1) {
+                            if (__atomic_compare_exchange_n(&Dist[y], &cur, d + 1, false,
+                                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                                if (cur > L && Parent[y] >= 0) {
+                                    myUnlinks.emplace_back(Parent[y], y);
+                                    Parent[y] = -1;
+                                }
+                                mine.push_back(y);
+                                return;
+                            }
+                        }
+                        if (cur == d + 1 &&
+                            __atomic_exchange_n(&queued[y], 1, __ATOMIC_RELAXED) == 0) {
+                            mineTouched.push_back(y);
+                        }
+                    });
+                }
+
+                buf.concat(next);
+            }
+            frontier.swap(next);
+        }
+        const int numLowered = static_cast<int>(lowered.size());
+        PerfCounters::add(Counter::Lowered, numLowered);
+        for (auto& l : touched.local) {
+            rescan.insert(rescan.end(), l.begin(), l.end());
+            l.clear();
+        }
+        for (int v : lowered) {
+            if (!queued[v]) {
+                queued[v] = 1;
+                rescan.push_back(v);
             }
         }
+
+        // 2) rescan from rank 1; T is patched after the loop
+        timer.emplace(Timer::Rescan);
+        std::vector<std::vector<std::pair<int,int>>> links(omp_get_max_threads());
+        const int numRescan = static_cast<int>(rescan.size());
+        #pragma omp parallel if(numRescan >= PHASE_PARALLEL_THRESH) reduction(+:probes, scanned)
+        {
+            int t = omp_get_thread_num();
+            auto& myLinks = links[t];
+            auto& myUnlinks = unlinks[t];
+
+            #pragma omp for schedule(dynamic, 16)
+            for (int j = 0; j < numRescan; ++j) {
+                int v = rescan[j];
+                queued[v] = 0;
+
+                Scan[v] = g.nextParent(v, 1, Dist.data(), Dist[v] - 1);
+                ++probes;
+                scanned += ranksPassed(1, Scan[v], g.inDegree(v));
+
+                // v was lowered through, or sits one level past, a live in-edge
+                int w = g.inNeighbor(v, Scan[v]);
+                if (w != Parent[v]) {
+                    if (Parent[v] >= 0) {
+                        myUnlinks.emplace_back(Parent[v], v);
+                    }
+                    Parent[v] = w;
+                    myLinks.emplace_back(w, v);
+                    PerfCounters::add(Counter::Reparented);
+                }
+            }
+        }
+
+        std::vector<std::pair<int,int>> oldEdges;
+        for (auto& l : unlinks) {
+            oldEdges.insert(oldEdges.end(), l.begin(), l.end());
+        }
+        detachChildren(oldEdges);
+        attachChildren(links);
+
+        // lowered vertices are among the rescanned ones
+        dirty.insert(dirty.end(), rescan.begin(), rescan.end());
+        stats.enqueued = numLowered;
+
+        timer.emplace(Timer::Publish);
+        publishSnapshot();
+        timer.reset();
+
+        stats.probes = probes;
+        stats.ranksScanned = scanned;
+        stats.seconds = omp_get_wtime() - start;
+    }
+
+    // what the last batchDelete / repair or batchInsert / relax cost
+    const BatchStats& lastBatchStats() const {
+        return stats;
+    }
+
+
+    // **Readers** -- safe to call from any thread while batchDelete runs.
+    // They never block: each sees the state after the last completed batch
+    // (or, if it overlaps a publish, retries and sees the newer one).
+
+    // Dist(v) in the published snapshot; L + 1 means farther than L
+    int distance(int v) const {
+        checkVertex(v, "distance: v out of range");
+        int d = 0;
+        readSnapshot([&](const Snapshot& S) {
+            d = __atomic_load_n(&S.dist[v], __ATOMIC_RELAXED);
+        });
+        return d;
+    }
+
+    // parent of v in T in the published snapshot; -1 for s and for unreached v
+    int parent(int v) const {
+        checkVertex(v, "parent: v out of range");
+        int p = -1;
+        readSnapshot([&](const Snapshot& S) {
+            p = __atomic_load_n(&S.parent[v], __ATOMIC_RELAXED);
+        });
+        return p;
+    }
+
+    // tree path s -> ... -> v in the published snapshot; empty if Dist(v) > L
+    std::vector<int> pathTo(int v) const {
+        checkVertex(v, "pathTo: v out of range");
+        std::vector<int> path;
+        readSnapshot([&](const Snapshot& S) {
+            path.clear();
+            if (__atomic_load_n(&S.dist[v], __ATOMIC_RELAXED) > L) {
+                return;
+            }
+            // bounded by L + 1 so a torn read cannot loop; it is retried anyway
+            for (int x = v; x != -1 && static_cast<int>(path.size()) <= L;
+                 x = __atomic_load_n(&S.parent[x], __ATOMIC_RELAXED)) {
+                path.push_back(x);
+            }
+            std::reverse(path.begin(), path.end());
+        });
+        return path;
+    }
+
+    // number of batches published so far
+    unsigned long epoch() const {
+        return epochCount.load(std::memory_order_acquire);
     }
 
 
+    // direction taken by each level of the initial BFS, for tuning BFS_ALPHA/BFS_BETA
+    const std::vector<BFSDirection>& initialBFSDirections() const {
+        return bfsDirections;
+    }
 
     void debugPrint() const {
         std::cout << "Dist:\n";
@@ -224,56 +2026,347 @@ private:
     int L;
     int s;
     std::vector<int> Dist;
-    std::vector<std::vector<int>> Out;
-    std::vector<PriorityStructure<int>> In;
+    std::shared_ptr<SharedGraph> G;     // Out, Rev and liveness, possibly shared
 
     std::vector<int> Scan;              // Scan(v) represents RANKs within In(v)
     std::vector<int> Parent;            // T, represented by parent map
     std::vector<std::vector<int>> Tv;   // T, represented by child map     
 
-    std::unordered_set<long long> alive;
+    std::vector<BFSDirection> bfsDirections;  // per level of the initial BFS
+
+    // Reader snapshots of Dist/Parent, double-buffered.  Readers use
+    // snap[published]; batchDelete brings the other buffer up to date and then
+    // flips published.  seq is a seqlock: odd while the buffer is being written.
+    struct Snapshot {
+        std::atomic<unsigned> seq{0};
+        std::vector<int> dist;
+        std::vector<int> parent;
+    };
+    Snapshot snap[2];
+    std::atomic<int> published{0};
+    std::atomic<unsigned long> epochCount{0};
+    std::vector<int> dirty;             // vertices whose Dist/Parent changed in this batch
+    std::vector<int> prevDirty;         // ... and in the previous one
+
+    // batchDelete scratch, all zero / empty between batches
+    std::vector<uint8_t> queued;                // v is already in the next U
+    std::vector<uint8_t> parentDeleted;         // v lost its tree edge and has no parent yet
+    std::vector<std::vector<int>> orphans;      // orphans[d]: parent-deleted vertices at Dist d
+
+    BatchStats stats;                           // of the last repair
+
+    // batchDelete rescans at least this many vertices before opening a team
+    static constexpr int PHASE_PARALLEL_THRESH = 64;
+
+    // Work stealing for skewed phases.  A rescan with at least SPLIT_RANKS
+    // ranks left in In(v), or a child fan-out of at least SPLIT_CHILDREN,
+    // becomes OpenMP tasks of STEAL_GRAIN ranks (children) each, which idle
+    // threads take over at the end of the loop: a phase then lasts about its
+    // total work over the team instead of as long as its biggest hub.  A phase
+    // holding such a vertex opens a team even when U is small.
+    static constexpr int STEAL_GRAIN = 1 << 12;
+    static constexpr int SPLIT_RANKS = 4 * STEAL_GRAIN;
+    static constexpr int SPLIT_CHILDREN = 4 * STEAL_GRAIN;
+
+    // v's rescan is long enough to be split
+    bool heavyScan(int v) const {
+        return G->inDegree(v) - std::max(Scan[v], 1) + 1 >= SPLIT_RANKS;
+    }
+
+    // ... or its fan-out, should In(v) run out
+    bool heavy(int v) const {
+        return heavyScan(v) || static_cast<int>(Tv[v].size()) >= SPLIT_CHILDREN;
+    }
+
+    // ranks of In(v) (size sz) passed over by a NEXTWITH from k that returned pos
+    static long long ranksPassed(int k, int pos, int sz) {
+        k = std::max(k, 1);
+        return k > sz ? 0 : std::min(pos, sz) - k + 1;
+    }
+
+    void checkVertex(int v, const char* what) const {
+        if (v < 0 || v >= n) {
+            throw std::out_of_range(what);
+        }
+    }
+
+    // run f on the published snapshot until it completes without a concurrent write
+    template <typename F>
+    void readSnapshot(F&& f) const {
+        for (;;) {
+            const Snapshot& S = snap[published.load(std::memory_order_acquire)];
+            unsigned before = S.seq.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;  // being rewritten: published has moved on
+            }
+            f(S);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (S.seq.load(std::memory_order_relaxed) == before) {
+                return;
+            }
+        }
+    }
+
+    // The back buffer was last written two batches ago, so it lacks the
+    // changes of the previous batch and of this one: copy exactly those
+    // vertices, then make it the published buffer.
+    void publishSnapshot() {
+        int back = 1 - published.load(std::memory_order_relaxed);
+        Snapshot& S = snap[back];
+
+        unsigned seq = S.seq.load(std::memory_order_relaxed);
+        S.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (const std::vector<int>* list : {&prevDirty, &dirty}) {
+            const int m = static_cast<int>(list->size());
+            #pragma omp parallel for if(m >= SharedGraph::DELETE_PARALLEL_THRESH)
+            for (int j = 0; j < m; ++j) {
+                int v = (*list)[j];
+                __atomic_store_n(&S.dist[v], Dist[v], __ATOMIC_RELAXED);
+                __atomic_store_n(&S.parent[v], Parent[v], __ATOMIC_RELAXED);
+            }
+        }
+
+        S.seq.store(seq + 2, std::memory_order_release);
+        published.store(back, std::memory_order_release);
+        epochCount.fetch_add(1, std::memory_order_release);
+
+        prevDirty.swap(dirty);
+        dirty.clear();
+    }
+
+    // Undo Tv[u].push_back(v) for every deleted tree edge (u, v).  Edges are
+    // grouped by parent so each Tv[u] is filtered once, by a single thread.
+    void detachChildren(std::vector<std::pair<int,int>>& edges) {
+        std::sort(edges.begin(), edges.end());
+
+        const long long m = static_cast<long long>(edges.size());
+        #pragma omp parallel for schedule(dynamic, 256) if(m >= PHASE_PARALLEL_THRESH)
+        for (long long j = 0; j < m; ++j) {
+            int u = edges[j].first;
+            if (j > 0 && edges[j - 1].first == u) {
+                continue;  // not the start of u's group
+            }
+            long long end = j;
+            while (end < m && edges[end].first == u) {
+                ++end;
+            }
+
+            auto first = edges.begin() + j;
+            auto last  = edges.begin() + end;
+            auto &kids = Tv[u];
+            kids.erase(std::remove_if(kids.begin(), kids.end(), [&](int c) {
+                return std::binary_search(first, last, std::make_pair(u, c));
+            }), kids.end());
+        }
+    }
+
+    // Tv[w].push_back(v) for every (w, v) collected by the threads, then empty
+    // the buffers.  Large batches are sorted by parent so that each Tv[w] is
+    // appended by a single thread.
+    void attachChildren(std::vector<std::vector<std::pair<int,int>>>& links) {
+        size_t total = 0;
+        for (const auto& l : links) {
+            total += l.size();
+        }
+
+        if (total < static_cast<size_t>(PHASE_PARALLEL_THRESH)) {
+            for (auto& l : links) {
+                for (auto [w, v] : l) {
+                    Tv[w].push_back(v);
+                }
+                l.clear();
+            }
+            return;
+        }
 
-    static long long encodeEdge(int u, int v) {
-        return (static_cast<long long>(u) << 32) ^
-               static_cast<unsigned int>(v);
+        std::vector<std::pair<int,int>> all;
+        all.reserve(total);
+        for (auto& l : links) {
+            all.insert(all.end(), l.begin(), l.end());
+            l.clear();
+        }
+        std::sort(all.begin(), all.end());
+
+        const long long m = static_cast<long long>(all.size());
+        #pragma omp parallel for schedule(dynamic, 256)
+        for (long long j = 0; j < m; ++j) {
+            int w = all[j].first;
+            if (j > 0 && all[j - 1].first == w) {
+                continue;  // not the start of w's group
+            }
+            for (long long k = j; k < m && all[k].first == w; ++k) {
+                Tv[w].push_back(all[k].second);
+            }
+        }
     }
 
     void initScanAndTree() {
-        Scan.assign(n, 0);
-        Parent.assign(n, -1);
+        const NumaLayout& numa = G->numa;
+        numa.fill(Scan, n, 0);
+        numa.fill(Parent, n, -1);
         Tv.assign(n, std::vector<int>());
 
-        for (int v = 0; v < n; v++) {
-
+        // first live in-edge from Dist[v] - 1; false if v has no parent
+        auto scanFirst = [&](int v) {
             int d = Dist[v];
             if (d == 0 || d > L) {
-                continue;
+                return false;
             }
 
-            auto predicate = [this, v](const int& w) -> bool {
-                if (w < 0 || w >= n) return false;
-                if (Dist[w] != Dist[v] - 1) return false;
-                long long key = encodeEdge(w, v);
-                return alive.find(key) != alive.end();
-            };
-
-            int pos = In[v].nextWith(1, predicate);
-            int sz  = In[v].size();
+            const SharedGraph& g = *G;
+            int pos = g.nextParent(v, 1, Dist.data(), d - 1);
+            int sz  = g.inDegree(v);
 
             if (pos >= 1 && pos <= sz) {
-                int w = In[v].query(pos);
                 Scan[v]   = pos;
-                Parent[v] = w;
-                Tv[w].push_back(v);
-            } else {
-                Scan[v] = sz + 1;
-                Parent[v] = -1;
+                Parent[v] = g.inNeighbor(v, pos);
+                return true;
+            }
+            Scan[v] = sz + 1;
+            Parent[v] = -1;
+            return false;
+        };
+
+        if (!numa.active()) {
+            for (int v = 0; v < n; v++) {
+                if (scanFirst(v)) {
+                    Tv[Parent[v]].push_back(v);
+                }
+            }
+            return;
+        }
+
+        // Placed: scans by v's socket, then each child list built by the
+        // parent's socket from the children grouped by parent (in order of v)
+        numa.forEachOwned(scanFirst, 256);
+        std::vector<int> childOffsets(n + 1, 0);
+        for (int v = 0; v < n; v++) {
+            if (Parent[v] >= 0) {
+                ++childOffsets[Parent[v] + 1];
+            }
+        }
+        parallelPrefixSum(childOffsets);
+        std::vector<int> children(childOffsets[n]);
+        {
+            std::vector<int> fill(childOffsets.begin(), childOffsets.end() - 1);
+            for (int v = 0; v < n; v++) {
+                if (Parent[v] >= 0) {
+                    children[fill[Parent[v]]++] = v;
+                }
+            }
+        }
+        numa.forEachOwned([&](int w) {
+            Tv[w].assign(children.begin() + childOffsets[w], children.begin() + childOffsets[w + 1]);
+        }, 1024);
+    }
+};
+
+
+// Several sources (landmarks) on one graph.  The graph side -- Out, Rev and
+// edge liveness -- is built and stored once; each source keeps only its own
+// Dist, Scan, Parent and T.  batchDelete marks the batch dead once and then
+// repairs all sources.
+class MultiSourceSSSP {
+public:
+    MultiSourceSSSP(const std::vector<std::vector<int>>& adjOut,
+                    const std::vector<int>& sources, int L)
+        : MultiSourceSSSP(CSRGraph(adjOut), sources, L) {}
+
+    MultiSourceSSSP(CSRGraph adjOut, const std::vector<int>& sources, int L)
+        : G(std::make_shared<SharedGraph>(std::move(adjOut))), trees(sources.size())
+    {
+        for (int s : sources) {
+            if (s < 0 || s >= G->numVertices()) {
+                throw std::out_of_range("MultiSourceSSSP: source out of range");
             }
         }
+
+        const int k = numSources();
+        #pragma omp parallel for schedule(dynamic, 1) if(acrossSources())
+        for (int j = 0; j < k; ++j) {
+            trees[j] = std::make_unique<DynamicSSSP>(G, sources[j], L);
+        }
+    }
+
+    // Write the graph once and then every source, in order
+    void save(const std::string& path) const {
+        snapshot::Writer out(path);
+        G->save(out);
+        out.put<int>(numSources());
+        for (const auto& t : trees) {
+            t->saveSource(out);
+        }
+        out.finish();
+    }
+
+    // A MultiSourceSSSP as save left it (see DynamicSSSP::load)
+    static std::unique_ptr<MultiSourceSSSP> load(const std::string& path) {
+        snapshot::Reader in(path);
+        std::unique_ptr<MultiSourceSSSP> ms(new MultiSourceSSSP(std::make_shared<SharedGraph>(in)));
+        const int k = in.get<int>();
+        if (k < 0) {
+            in.fail("negative source count");
+        }
+        for (int j = 0; j < k; ++j) {
+            ms->trees.push_back(std::make_unique<DynamicSSSP>(ms->G, in));
+        }
+        return ms;
+    }
+
+    int numSources() const {
+        return static_cast<int>(trees.size());
+    }
+
+    // the j-th source, in the order given to the constructor
+    DynamicSSSP& source(int j) {
+        return *trees.at(j);
+    }
+    const DynamicSSSP& source(int j) const {
+        return *trees.at(j);
+    }
+
+    // Algorithm 1 for every source: the graph marks the batch dead once, then
+    // each source repairs its tree from the edges that actually died.
+    void batchDelete(const std::vector<std::pair<int,int>>& delEdges) {
+        std::vector<std::pair<int,int>> killed = G->deleteEdges(delEdges);
+
+        const int k = numSources();
+        #pragma omp parallel for schedule(dynamic, 1) if(acrossSources())
+        for (int j = 0; j < k; ++j) {
+            trees[j]->repair(killed);
+        }
+    }
+
+    // Insertions for every source: the graph makes the batch live once, then
+    // each source lowers its distances over the edges that actually came back.
+    void batchInsert(const std::vector<std::pair<int,int>>& insEdges) {
+        std::vector<std::pair<int,int>> added = G->insertEdges(insEdges);
+
+        const int k = numSources();
+        #pragma omp parallel for schedule(dynamic, 1) if(acrossSources())
+        for (int j = 0; j < k; ++j) {
+            trees[j]->relax(added);
+        }
+    }
+
+private:
+    std::shared_ptr<SharedGraph> G;
+    std::vector<std::unique_ptr<DynamicSSSP>> trees;
+
+    // no sources yet; load adds them
+    explicit MultiSourceSSSP(std::shared_ptr<SharedGraph> graph) : G(std::move(graph)), trees() {}
+
+    // With at least one source per thread, run sources side by side (each one
+    // serially); with fewer, run them one after another, each using the team.
+    bool acrossSources() const {
+        return numSources() > 1 && numSources() >= omp_get_max_threads();
     }
 };
 
 
+#ifndef NO_DEMO_MAIN
 int main() {
     // Example graph:
     //
@@ -312,6 +2405,34 @@ int main() {
     std::cout << "\nAfter batchDelete({(2,3)}):\n";
     dsssp.debugPrint();
 
+    // Read API: what a concurrent reader would see after the batch
+    std::cout << "\nReader view (epoch " << dsssp.epoch() << "): distance(5) = "
+              << dsssp.distance(5) << ", path to 5 =";
+    for (int v : dsssp.pathTo(5)) {
+        std::cout << " " << v;
+    }
+    std::cout << "\n";
+
+    // Example batch insertion: (2,3) comes back, (0,5) is a new edge
+    dsssp.batchInsert({{2,3}, {0,5}});
+
+    std::cout << "\nAfter batchInsert({(2,3), (0,5)}):\n";
+    dsssp.debugPrint();
+
+    // A repeated edge is one edge: deleting (0,1) once cuts 1 off
+    DynamicSSSP dup(std::vector<std::vector<int>>{{1, 1}, {}}, 0, L);
+    dup.batchDelete({{0, 1}});
+    std::cout << "\nRepeated edge (0,1) after one delete: distance(1) = " << dup.distance(1)
+              << (dup.distance(1) == L + 1 ? " (unreached)" : " (WRONG: still reached)") << "\n";
+
+    // Chain 0 -> 1 -> 2 with L = 2: deleting (0,1) leaves 1 and 2 unreached,
+    // and an unreached vertex has no parent
+    DynamicSSSP chain(std::vector<std::vector<int>>{{1}, {2}, {}}, 0, 2);
+    chain.batchDelete({{0, 1}});
+    std::cout << "Chain after batchDelete({(0,1)}): distance(2) = " << chain.distance(2)
+              << ", parent(2) = " << chain.parent(2)
+              << (chain.parent(2) == -1 ? "" : " (WRONG: stale parent)") << "\n";
+
 
 
     // Cycle
@@ -346,5 +2467,19 @@ int main() {
     std::cout << "\nAfter batchDelete({(0,1)}):\n";
     dsssp2.debugPrint();
 
+    // Two landmarks on the cycle sharing one graph
+    MultiSourceSSSP landmarks(adj, {0, 2}, L);
+    landmarks.batchDelete({{0, 4}, {3, 2}});
+
+    std::cout << "\nTwo sources after batchDelete({(0,4), (3,2)}):\n";
+    for (int j = 0; j < landmarks.numSources(); ++j) {
+        std::cout << "  source " << j << ":";
+        for (int v = 0; v < n; ++v) {
+            std::cout << " " << landmarks.source(j).distance(v);
+        }
+        std::cout << "\n";
+    }
+
     return 0;
 }
+#endif
@@ -0,0 +1,908 @@
+// Theorem 1.2 across nodes: DynamicSSSP with its vertices split over MPI ranks.
+//
+// VertexPartition cuts the ids into one contiguous block per rank.  A rank
+// keeps, for the vertices it owns, Dist, Scan, Parent and the children T(v),
+// their out-edges, and their in-edges in rows sorted by u, which are In(v)
+// exactly as in SharedGraph (priority n - u, rank k = k-th in-edge of the row).
+// The one remote input of NEXTWITH on In(v), "in-edge (u, v) alive and
+// Dist(u) == Dist(v) - 1", is Dist(u) for a tail u owned elsewhere: such a u
+// is a ghost of the rank, which holds a copy of Dist(u).  The owner of u knows
+// which ranks hold it and sends them Dist(u) each time it changes.
+//
+// The bounded BFS and Algorithm 1 run as bulk-synchronous supersteps: local
+// work on the owned vertices (OpenMP within the rank), then one all-to-all of
+// the messages that work produced.
+//   BFS level    reached out-neighbors for their owners
+//   after BFS    Dist of the reached vertices, for their ghosts
+//   batch start  each deleted edge, for the owners of both of its ends
+//   first pass   detached and new (parent, child) links, for the parent's owner
+//   phase i      children moved into Unew and new (parent, child) links, for
+//                the owners of the child and the parent; then Dist = i + 1 of
+//                the new U, for its ghosts
+// Only the Dist values that change travel, and only to ranks that read them.
+//
+// Every call marked collective must be made by all ranks of the communicator,
+// in the same order.  Edges passed to one may be held by any rank, any number
+// of times: each is routed to the owners of its ends and deduplicated there.
+//
+// The demo main needs bfs_array from bfs_tree.cpp.
+// Initialize MPI with at least MPI_THREAD_FUNNELED.
+
+#include <mpi.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+#include <type_traits>
+#include <omp.h>
+
+
+// Vertex ids [0, n) in contiguous blocks of ceil(n / ranks), one per rank
+class VertexPartition {
+public:
+    VertexPartition() = default;
+
+    VertexPartition(int n, int ranks)
+        : n(n), ranks(ranks), block(std::max(1, static_cast<int>((static_cast<long long>(n) + ranks - 1) / ranks))) {}
+
+    int numVertices() const { return n; }
+    int numRanks() const { return ranks; }
+
+    int owner(int v) const { return v / block; }
+    int begin(int r) const { return static_cast<int>(std::min<long long>(n, static_cast<long long>(r) * block)); }
+    int end(int r) const { return begin(r + 1); }
+
+private:
+    int n = 0;
+    int ranks = 1;
+    int block = 1;
+};
+
+
+namespace mpi_exchange {
+
+// Message buffers for one superstep: one per destination rank, per thread so
+// that push needs no lock (call it from the threads of one parallel region).
+template <typename T>
+class Outbox {
+    // messages travel as bytes (std::pair of ints included, whose assignment
+    // alone is not trivial)
+    static_assert(std::is_trivially_copy_constructible<T>::value &&
+                  std::is_trivially_destructible<T>::value, "messages travel as bytes");
+
+public:
+    Outbox(MPI_Comm comm, int ranks)
+        : comm(comm), ranks(ranks),
+          local(omp_get_max_threads(), std::vector<std::vector<T>>(ranks)) {}
+
+    void push(int dest, const T& item) {
+        local[omp_get_thread_num()][dest].push_back(item);
+    }
+
+    // Collective: deliver every buffer and return the messages sent to this
+    // rank, in order of the sender (its own come first, without a copy through
+    // MPI).  Adds the bytes this rank sent to bytesSent.  Buffers are left empty.
+    std::vector<T> exchange(long long& bytesSent) {
+        int me;
+        MPI_Comm_rank(comm, &me);
+
+        std::vector<T> received;
+        std::vector<long long> count(ranks, 0);
+        for (auto& perRank : local) {
+            for (int r = 0; r < ranks; ++r) {
+                count[r] += static_cast<long long>(perRank[r].size());
+            }
+            received.insert(received.end(), perRank[me].begin(), perRank[me].end());
+            perRank[me].clear();
+        }
+        count[me] = 0;
+
+        std::vector<int> sendBytes(ranks), sendDispl(ranks);
+        long long total = 0;
+        for (int r = 0; r < ranks; ++r) {
+            sendBytes[r] = checkedInt(count[r] * static_cast<long long>(sizeof(T)));
+            sendDispl[r] = checkedInt(total);
+            total += sendBytes[r];
+        }
+        std::vector<char> sendBuf(total);
+        {
+            std::vector<long long> fill(sendDispl.begin(), sendDispl.end());
+            for (auto& perRank : local) {
+                for (int r = 0; r < ranks; ++r) {
+                    const size_t bytes = perRank[r].size() * sizeof(T);
+                    if (bytes > 0) {
+                        std::memcpy(sendBuf.data() + fill[r], perRank[r].data(), bytes);
+                    }
+                    fill[r] += static_cast<long long>(bytes);
+                    perRank[r].clear();
+                }
+            }
+        }
+        bytesSent += total;
+
+        std::vector<int> recvBytes(ranks), recvDispl(ranks);
+        MPI_Alltoall(sendBytes.data(), 1, MPI_INT, recvBytes.data(), 1, MPI_INT, comm);
+        long long recvTotal = 0;
+        for (int r = 0; r < ranks; ++r) {
+            recvDispl[r] = checkedInt(recvTotal);
+            recvTotal += recvBytes[r];
+        }
+
+        const size_t own = received.size();
+        received.resize(own + static_cast<size_t>(recvTotal) / sizeof(T));
+        MPI_Alltoallv(sendBuf.data(), sendBytes.data(), sendDispl.data(), MPI_BYTE,
+                      reinterpret_cast<char*>(received.data() + own), recvBytes.data(),
+                      recvDispl.data(), MPI_BYTE, comm);
+        return received;
+    }
+
+private:
+    MPI_Comm comm;
+    int ranks;
+    std::vector<std::vector<std::vector<T>>> local;  // [thread][destination]
+
+    // MPI counts and displacements are int
+    static int checkedInt(long long bytes) {
+        if (bytes > INT_MAX) {
+            throw std::out_of_range("Outbox: a superstep sends more than INT_MAX bytes to one rank");
+        }
+        return static_cast<int>(bytes);
+    }
+};
+
+// true on every rank if cond holds on any (collective)
+inline bool anyRank(MPI_Comm comm, bool cond) {
+    int local = cond ? 1 : 0;
+    int global = 0;
+    MPI_Allreduce(&local, &global, 1, MPI_INT, MPI_LOR, comm);
+    return global != 0;
+}
+
+inline long long sumRanks(MPI_Comm comm, long long x) {
+    long long total = 0;
+    MPI_Allreduce(&x, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    return total;
+}
+
+inline int maxRanks(MPI_Comm comm, int x) {
+    int best = 0;
+    MPI_Allreduce(&x, &best, 1, MPI_INT, MPI_MAX, comm);
+    return best;
+}
+
+} // namespace mpi_exchange
+
+
+// Per-rank share of a DynamicSSSP (one source, bounded depth L) over a
+// vertex-partitioned graph, decremental (batchDelete)
+class DistributedSSSP {
+public:
+    // Cost of one batchDelete, summed over all ranks (seconds: the slowest rank)
+    struct BatchStats {
+        long long killed = 0;         // edges that died in the batch
+        long long treeEdges = 0;      // ... of which were edges of T
+        std::vector<long long> phaseU;// |U| at the start of each phase run
+        int supersteps = 0;           // all-to-all exchanges, BFS levels included
+        long long probes = 0;         // NEXTWITH calls on In(v)
+        long long ranksScanned = 0;   // In(v) ranks those calls passed over
+        long long enqueued = 0;       // vertices moved into U, over all phases
+        long long bytesSent = 0;      // message payload between ranks
+        double seconds = 0;           // wall time of batchDelete
+    };
+
+    // Collective.  edges: any subset of the graph (see above); every rank
+    // passes the same n, s and L.
+    DistributedSSSP(MPI_Comm parent, int n, const std::vector<std::pair<int,int>>& edges, int s, int L)
+        : n(n), L(L), s(s)
+    {
+        MPI_Comm_dup(parent, &comm);
+        MPI_Comm_rank(comm, &me);
+        MPI_Comm_size(comm, &ranks);
+        if (mpi_exchange::anyRank(comm, n < 0 || s < 0 || s >= n || L < 0)) {
+            MPI_Comm_free(&comm);
+            throw std::out_of_range("DistributedSSSP: bad n, source or L");
+        }
+        part = VertexPartition(n, ranks);
+        lo = part.begin(me);
+        nLocal = part.end(me) - lo;
+        distributeEdges(edges);
+        buildGhosts();
+
+        // Dist by the bounded BFS, then Scan, Parent and T from it
+        std::vector<int> d = boundedBFS(initSupersteps);
+        std::copy(d.begin(), d.end(), dist.begin());
+        std::vector<int> reached;
+        for (int v = 0; v < nLocal; ++v) {
+            if (dist[v] <= L) {
+                reached.push_back(v);
+            }
+        }
+        long long bytes = 0;
+        publishDist(reached, bytes);
+        ++initSupersteps;
+        initScanAndTree();
+        ++initSupersteps;
+
+        queued.assign(nLocal, 0);
+        parentDeleted.assign(nLocal, 0);
+        orphans.assign(L + 2, std::vector<int>());
+    }
+
+    ~DistributedSSSP() {
+        MPI_Comm_free(&comm);
+    }
+
+    DistributedSSSP(const DistributedSSSP&) = delete;
+    DistributedSSSP& operator=(const DistributedSSSP&) = delete;
+
+    int numVertices() const { return n; }
+    int depthBound() const { return L; }
+    int source() const { return s; }
+    int rank() const { return me; }
+    int numRanks() const { return ranks; }
+    const VertexPartition& partition() const { return part; }
+
+    bool owns(int v) const {
+        return v >= lo && v < lo + nLocal;
+    }
+
+    // this rank's share: owned vertices, their live in- and out-edges at
+    // construction, and the ghosts it reads
+    int numOwned() const { return nLocal; }
+    long long numOwnedInEdges() const { return static_cast<long long>(inSources.size()); }
+    long long numOwnedOutEdges() const { return static_cast<long long>(outTargets.size()); }
+    int numGhosts() const { return static_cast<int>(ghosts.size()); }
+
+    // supersteps the constructor took (BFS levels, ghost push, tree links)
+    int buildSupersteps() const { return initSupersteps; }
+
+    // **API FUNCTION**
+    // Dist(v) for an owned v; L + 1 means farther than L
+    int distance(int v) const {
+        return dist[checkOwned(v)];
+    }
+
+    // parent of an owned v in T, or -1
+    int parent(int v) const {
+        return Parent[checkOwned(v)];
+    }
+
+    // Dist of the owned vertices, from part.begin(rank) on
+    std::vector<int> localDistances() const {
+        return std::vector<int>(dist.begin(), dist.begin() + nLocal);
+    }
+
+    // f(u, v) for the live out-edges of the owned vertices u
+    template <typename F>
+    void forEachOwnedOutEdge(F&& f) const {
+        for (int u = 0; u < nLocal; ++u) {
+            for (int e = outOffsets[u]; e < outOffsets[u + 1]; ++e) {
+                if (isLive(outAlive, e)) {
+                    f(lo + u, outTargets[e]);
+                }
+            }
+        }
+    }
+
+    // f(Parent(v), v) for the owned v within L that have a parent
+    template <typename F>
+    void forEachOwnedTreeEdge(F&& f) const {
+        for (int v = 0; v < nLocal; ++v) {
+            if (dist[v] <= L && Parent[v] >= 0) {
+                f(Parent[v], lo + v);
+            }
+        }
+    }
+
+    // Collective.  Dist of the owned vertices computed from scratch by the
+    // bounded BFS over the live edges (no state is touched).
+    std::vector<int> recompute() const {
+        int supersteps = 0;
+        return boundedBFS(supersteps);
+    }
+
+    // Collective.  The whole Dist array on root (empty elsewhere), for checks
+    // on graphs small enough to gather.
+    std::vector<int> gatherDistances(int root) const {
+        std::vector<int> counts(ranks), displs(ranks);
+        for (int r = 0; r < ranks; ++r) {
+            counts[r] = part.end(r) - part.begin(r);
+            displs[r] = part.begin(r);
+        }
+        std::vector<int> all(me == root ? n : 0);
+        MPI_Gatherv(dist.data(), nLocal, MPI_INT, all.data(), counts.data(), displs.data(),
+                    MPI_INT, root, comm);
+        return all;
+    }
+
+    // what the last batchDelete cost
+    const BatchStats& lastBatchStats() const {
+        return stats;
+    }
+
+    // **API FUNCTION**
+    // Collective.  Algorithm 1 for a batch of deletions; every rank passes the
+    // edges it holds (pairs that are not live edges are ignored).
+    void batchDelete(const std::vector<std::pair<int,int>>& delEdges) {
+        const double start = MPI_Wtime();
+        stats = BatchStats();
+        long long killed = 0;
+        long long bytes = 0;
+        long long probes = 0;
+        long long scanned = 0;
+        long long enqueued = 0;
+        int supersteps = 0;
+
+        bool badId = false;
+        for (auto [u, v] : delEdges) {
+            badId |= u < 0 || u >= n || v < 0 || v >= n;
+        }
+        if (mpi_exchange::anyRank(comm, badId)) {
+            throw std::out_of_range("DistributedSSSP::batchDelete: vertex out of range");
+        }
+
+        // Kill each edge at both ends: the owner of u clears its out-edge, the
+        // owner of v its in-edge, and the latter finds the deleted tree edges.
+        std::vector<Message> arrived;
+        {
+            mpi_exchange::Outbox<Message> out(comm, ranks);
+            const int m = static_cast<int>(delEdges.size());
+            #pragma omp parallel for schedule(static) if(m >= PARALLEL_THRESH)
+            for (int j = 0; j < m; ++j) {
+                auto [u, v] = delEdges[j];
+                if (u != v) {
+                    out.push(part.owner(u), {KillOut, u, v});
+                    out.push(part.owner(v), {KillIn, u, v});
+                }
+            }
+            arrived = out.exchange(bytes);
+            ++supersteps;
+        }
+
+        std::vector<std::pair<int,int>> treeEdges;   // (parent, local child)
+        {
+            std::vector<std::vector<std::pair<int,int>>> found(omp_get_max_threads());
+            const int m = static_cast<int>(arrived.size());
+            #pragma omp parallel for schedule(static) reduction(+:killed) if(m >= PARALLEL_THRESH)
+            for (int j = 0; j < m; ++j) {
+                const Message& msg = arrived[j];
+                if (msg.kind == KillOut) {
+                    int e = findEdge(outOffsets, outTargets, msg.a - lo, msg.b);
+                    if (e >= 0) {
+                        kill(outAlive, e);
+                    }
+                    continue;
+                }
+                const int v = msg.b - lo;
+                int e = findEdge(inOffsets, inSources, v, msg.a);
+                if (e >= 0 && kill(inAlive, e)) {  // first copy of the edge to arrive
+                    ++killed;
+                    if (Parent[v] == msg.a) {
+                        found[omp_get_thread_num()].emplace_back(msg.a, v);
+                    }
+                }
+            }
+            for (auto& f : found) {
+                treeEdges.insert(treeEdges.end(), f.begin(), f.end());
+            }
+        }
+
+        // First pass: orphan the children of deleted tree edges; second pass:
+        // each rescans In(v) from Scan(v) at its own distance.  The detach and
+        // the new link of a child go out in one superstep (the parents differ,
+        // as the old edge is dead).
+        int lastBucket = 0;
+        for (auto [u, v] : treeEdges) {
+            parentDeleted[v] = 1;
+            orphans[dist[v]].push_back(v);
+            lastBucket = std::max(lastBucket, dist[v]);
+            Parent[v] = -1;
+        }
+        {
+            mpi_exchange::Outbox<Message> out(comm, ranks);
+            const int numTree = static_cast<int>(treeEdges.size());
+            #pragma omp parallel for schedule(dynamic, 16) reduction(+:probes, scanned) if(numTree >= PARALLEL_THRESH)
+            for (int j = 0; j < numTree; ++j) {
+                auto [u, v] = treeEdges[j];
+                out.push(part.owner(u), {Detach, u, lo + v});
+                if (rescanFrom(v, probes, scanned)) {
+                    const int w = inSources[inOffsets[v] + Scan[v] - 1];
+                    Parent[v] = w;
+                    parentDeleted[v] = 0;
+                    out.push(part.owner(w), {Attach, w, lo + v});
+                }
+            }
+            applyLinks(out.exchange(bytes));
+            ++supersteps;
+        }
+        lastBucket = mpi_exchange::maxRanks(comm, lastBucket);
+
+        // ---- Phases i = 0..L (Algorithm 1 lines 4–15), one or two supersteps each ----
+        // As in DynamicSSSP::repair: every v in U sits at Dist i and a new parent
+        // at Dist i - 1, which no rank changes during the phase.
+        std::vector<int> U;      // local ids
+        for (int i = 0; i <= L; i++) {
+            const long long numUAll = mpi_exchange::sumRanks(comm, static_cast<long long>(U.size()));
+            if (numUAll == 0 && i + 1 > lastBucket) {
+                break;
+            }
+            stats.phaseU.push_back(numUAll);
+
+            mpi_exchange::Outbox<Message> out(comm, ranks);
+            std::vector<std::vector<int>> next(omp_get_max_threads());
+            const int numU = static_cast<int>(U.size());
+            std::vector<int>& bucket = orphans[i + 1];
+            const int numBucket = static_cast<int>(bucket.size());
+
+            #pragma omp parallel if(numU + numBucket >= PARALLEL_THRESH) reduction(+:probes, scanned)
+            {
+                std::vector<int>& mine = next[omp_get_thread_num()];
+                auto enqueue = [&](int x) {
+                    if (__atomic_exchange_n(&queued[x], 1, __ATOMIC_RELAXED) == 0) {
+                        mine.push_back(x);
+                    }
+                };
+
+                // lines 6-11
+                #pragma omp for schedule(dynamic, 16) nowait
+                for (int j = 0; j < numU; ++j) {
+                    const int v = U[j];
+                    if (!rescanFrom(v, probes, scanned)) {
+                        Scan[v] = 1;
+                        enqueue(v);
+                        for (int child : Tv[v]) {
+                            if (owns(child)) {
+                                enqueue(child - lo);
+                            } else {
+                                out.push(part.owner(child), {Enqueue, child, 0});
+                            }
+                        }
+                        Tv[v] = std::vector<int>();
+                    } else {
+                        const int w = inSources[inOffsets[v] + Scan[v] - 1];
+                        Parent[v] = w;
+                        out.push(part.owner(w), {Attach, w, lo + v});
+                    }
+                }
+
+                // line 12
+                #pragma omp for schedule(static)
+                for (int j = 0; j < numBucket; ++j) {
+                    const int v = bucket[j];
+                    if (dist[v] == i + 1 && parentDeleted[v]) {
+                        enqueue(v);
+                    }
+                    parentDeleted[v] = 0;
+                }
+            }
+            bucket.clear();
+
+            std::vector<Message> msgs = out.exchange(bytes);
+            ++supersteps;
+            std::vector<int> Unew;
+            for (auto& t : next) {
+                Unew.insert(Unew.end(), t.begin(), t.end());
+            }
+            for (const Message& msg : msgs) {
+                if (msg.kind == Enqueue) {
+                    const int x = msg.a - lo;
+                    if (!queued[x]) {
+                        queued[x] = 1;
+                        Unew.push_back(x);
+                    }
+                }
+            }
+            applyLinks(msgs);
+
+            // lines 13-15, and the new Dist for the ghosts of U
+            U.swap(Unew);
+            const int numNext = static_cast<int>(U.size());
+            #pragma omp parallel for if(numNext >= PARALLEL_THRESH)
+            for (int j = 0; j < numNext; ++j) {
+                dist[U[j]] = i + 1;
+                queued[U[j]] = 0;
+            }
+            enqueued += numNext;
+            if (mpi_exchange::anyRank(comm, numNext > 0 && anySubscribed(U))) {
+                publishDist(U, bytes);
+                ++supersteps;
+            }
+        }
+
+        stats.killed = mpi_exchange::sumRanks(comm, killed);
+        stats.treeEdges = mpi_exchange::sumRanks(comm, static_cast<long long>(treeEdges.size()));
+        stats.probes = mpi_exchange::sumRanks(comm, probes);
+        stats.ranksScanned = mpi_exchange::sumRanks(comm, scanned);
+        stats.enqueued = mpi_exchange::sumRanks(comm, enqueued);
+        stats.bytesSent = mpi_exchange::sumRanks(comm, bytes);
+        stats.supersteps = supersteps;
+        double elapsed = MPI_Wtime() - start;
+        MPI_Allreduce(&elapsed, &stats.seconds, 1, MPI_DOUBLE, MPI_MAX, comm);
+    }
+
+private:
+    // a superstep message; (a, b) is an edge (u, v), a (parent, child) link or
+    // (vertex, -) to enqueue
+    enum Kind : int { KillOut, KillIn, Detach, Attach, Enqueue };
+    struct Message {
+        int kind;
+        int a;
+        int b;
+    };
+
+    // below this many items a local loop runs on one thread
+    static constexpr int PARALLEL_THRESH = 2048;
+
+    MPI_Comm comm;
+    int me = 0;
+    int ranks = 1;
+    int n;
+    int L;
+    int s;
+    VertexPartition part;
+    int lo = 0;                          // first owned id
+    int nLocal = 0;                      // owned ids are [lo, lo + nLocal)
+    int initSupersteps = 0;
+
+    // owned rows, indexed by local id; targets and sources are global ids
+    std::vector<int> outOffsets, outTargets;
+    std::vector<int> inOffsets, inSources;   // in-rows sorted by u: rank k is edge inOffsets[v] + k - 1
+    std::vector<uint64_t> outAlive, inAlive; // bit e: edge e is live
+
+    // dist[0, nLocal) is Dist of the owned vertices, dist[nLocal + g] the copy
+    // of Dist(ghosts[g]); inSlot[e] is where the tail of in-edge e is found
+    std::vector<int> dist;
+    std::vector<int> ghosts;                 // sorted global ids
+    std::vector<int> inSlot;
+    std::vector<int> subOffsets, subRanks;   // ranks holding owned v as a ghost
+
+    std::vector<int> Scan;
+    std::vector<int> Parent;                 // global ids
+    std::vector<std::vector<int>> Tv;        // children, global ids
+    std::vector<uint8_t> queued;             // v is already in the next U
+    std::vector<uint8_t> parentDeleted;
+    std::vector<std::vector<int>> orphans;   // orphans[d]: children of deleted tree edges at Dist d
+
+    BatchStats stats;
+
+    int checkOwned(int v) const {
+        if (!owns(v)) {
+            throw std::out_of_range("DistributedSSSP: vertex not owned by this rank");
+        }
+        return v - lo;
+    }
+
+    static bool isLive(const std::vector<uint64_t>& bits, int e) {
+        return (__atomic_load_n(&bits[e >> 6], __ATOMIC_RELAXED) >> (e & 63)) & 1;
+    }
+
+    // clear bit e; true if this call cleared it
+    static bool kill(std::vector<uint64_t>& bits, int e) {
+        const uint64_t mask = uint64_t(1) << (e & 63);
+        return __atomic_fetch_and(&bits[e >> 6], ~mask, __ATOMIC_RELAXED) & mask;
+    }
+
+    // edge id of x in the sorted row of local v, or -1
+    static int findEdge(const std::vector<int>& offsets, const std::vector<int>& targets, int v, int x) {
+        auto first = targets.begin() + offsets[v];
+        auto last = targets.begin() + offsets[v + 1];
+        auto it = std::lower_bound(first, last, x);
+        return (it != last && *it == x) ? static_cast<int>(it - targets.begin()) : -1;
+    }
+
+    // (owned id, other end) pairs into sorted, deduplicated rows
+    void buildRows(std::vector<std::pair<int,int>>& pairs, std::vector<int>& offsets,
+                   std::vector<int>& targets, std::vector<uint64_t>& alive) const {
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+        offsets.assign(nLocal + 1, 0);
+        targets.resize(pairs.size());
+        for (size_t j = 0; j < pairs.size(); ++j) {
+            ++offsets[pairs[j].first - lo + 1];
+            targets[j] = pairs[j].second;
+        }
+        for (int v = 0; v < nLocal; ++v) {
+            offsets[v + 1] += offsets[v];
+        }
+        alive.assign((targets.size() + 63) / 64, ~uint64_t(0));
+    }
+
+    // each edge to the owner of u (out-row) and of v (in-row)
+    void distributeEdges(const std::vector<std::pair<int,int>>& edges) {
+        bool badId = false;
+        for (auto [u, v] : edges) {
+            badId |= u < 0 || u >= n || v < 0 || v >= n;
+        }
+        if (mpi_exchange::anyRank(comm, badId)) {
+            MPI_Comm_free(&comm);
+            throw std::out_of_range("DistributedSSSP: vertex out of range");
+        }
+
+        long long bytes = 0;
+        mpi_exchange::Outbox<std::pair<int,int>> byTail(comm, ranks), byHead(comm, ranks);
+        const long long m = static_cast<long long>(edges.size());
+        #pragma omp parallel for schedule(static)
+        for (long long j = 0; j < m; ++j) {
+            auto [u, v] = edges[j];
+            if (u != v) {
+                byTail.push(part.owner(u), {u, v});
+                byHead.push(part.owner(v), {v, u});
+            }
+        }
+        std::vector<std::pair<int,int>> out = byTail.exchange(bytes);
+        buildRows(out, outOffsets, outTargets, outAlive);
+        std::vector<std::pair<int,int>> in = byHead.exchange(bytes);
+        buildRows(in, inOffsets, inSources, inAlive);
+        if (mpi_exchange::anyRank(comm, inSources.size() > static_cast<size_t>(INT_MAX) ||
+                                        outTargets.size() > static_cast<size_t>(INT_MAX))) {
+            MPI_Comm_free(&comm);
+            throw std::out_of_range("DistributedSSSP: more edges on one rank than an int edge id can hold");
+        }
+    }
+
+    // ghosts, the slot of every in-edge tail, and who subscribes to what
+    void buildGhosts() {
+        for (int u : inSources) {
+            if (!owns(u)) {
+                ghosts.push_back(u);
+            }
+        }
+        std::sort(ghosts.begin(), ghosts.end());
+        ghosts.erase(std::unique(ghosts.begin(), ghosts.end()), ghosts.end());
+
+        inSlot.resize(inSources.size());
+        #pragma omp parallel for schedule(static)
+        for (long long e = 0; e < static_cast<long long>(inSources.size()); ++e) {
+            const int u = inSources[e];
+            inSlot[e] = owns(u) ? u - lo
+                                : nLocal + static_cast<int>(std::lower_bound(ghosts.begin(), ghosts.end(), u) - ghosts.begin());
+        }
+        dist.assign(nLocal + ghosts.size(), L + 1);
+
+        // tell each owner which of its vertices this rank reads
+        long long bytes = 0;
+        mpi_exchange::Outbox<std::pair<int,int>> ask(comm, ranks);
+        for (int u : ghosts) {
+            ask.push(part.owner(u), {u - part.begin(part.owner(u)), me});
+        }
+        std::vector<std::pair<int,int>> subs = ask.exchange(bytes);
+        std::sort(subs.begin(), subs.end());
+        subOffsets.assign(nLocal + 1, 0);
+        subRanks.resize(subs.size());
+        for (size_t j = 0; j < subs.size(); ++j) {
+            ++subOffsets[subs[j].first + 1];
+            subRanks[j] = subs[j].second;
+        }
+        for (int v = 0; v < nLocal; ++v) {
+            subOffsets[v + 1] += subOffsets[v];
+        }
+    }
+
+    // Dist of the owned vertices by top-down levels over the live out-edges,
+    // one superstep per level (collective)
+    std::vector<int> boundedBFS(int& supersteps) const {
+        const int unseen = L + 1;
+        std::vector<int> d(nLocal, unseen);
+        std::vector<int> frontier;
+        if (owns(s)) {
+            d[s - lo] = 0;
+            frontier.push_back(s - lo);
+        }
+
+        long long bytes = 0;
+        for (int level = 1; level <= L; ++level) {
+            if (!mpi_exchange::anyRank(comm, !frontier.empty())) {
+                break;
+            }
+            mpi_exchange::Outbox<int> out(comm, ranks);
+            std::vector<std::vector<int>> next(omp_get_max_threads());
+            const int f = static_cast<int>(frontier.size());
+            #pragma omp parallel for schedule(dynamic, 64) if(f >= PARALLEL_THRESH / 16)
+            for (int j = 0; j < f; ++j) {
+                const int u = frontier[j];
+                for (int e = outOffsets[u]; e < outOffsets[u + 1]; ++e) {
+                    if (!isLive(outAlive, e)) {
+                        continue;
+                    }
+                    const int w = outTargets[e];
+                    if (!owns(w)) {
+                        out.push(part.owner(w), w);
+                        continue;
+                    }
+                    int expected = unseen;
+                    if (__atomic_load_n(&d[w - lo], __ATOMIC_RELAXED) == unseen &&
+                        __atomic_compare_exchange_n(&d[w - lo], &expected, level, false,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                        next[omp_get_thread_num()].push_back(w - lo);
+                    }
+                }
+            }
+            std::vector<int> reached = out.exchange(bytes);
+            ++supersteps;
+
+            frontier.clear();
+            for (auto& t : next) {
+                frontier.insert(frontier.end(), t.begin(), t.end());
+            }
+            for (int w : reached) {
+                if (d[w - lo] == unseen) {
+                    d[w - lo] = level;
+                    frontier.push_back(w - lo);
+                }
+            }
+        }
+        return d;
+    }
+
+    // send Dist of the owned vertices vs to the ranks holding them (collective)
+    void publishDist(const std::vector<int>& vs, long long& bytes) {
+        mpi_exchange::Outbox<std::pair<int,int>> out(comm, ranks);
+        const int m = static_cast<int>(vs.size());
+        #pragma omp parallel for schedule(dynamic, 256) if(m >= PARALLEL_THRESH)
+        for (int j = 0; j < m; ++j) {
+            const int v = vs[j];
+            for (int k = subOffsets[v]; k < subOffsets[v + 1]; ++k) {
+                out.push(subRanks[k], {lo + v, dist[v]});
+            }
+        }
+        std::vector<std::pair<int,int>> updates = out.exchange(bytes);
+        const long long numUpdates = static_cast<long long>(updates.size());
+        #pragma omp parallel for schedule(static) if(numUpdates >= PARALLEL_THRESH)
+        for (long long j = 0; j < numUpdates; ++j) {
+            auto [u, du] = updates[j];
+            dist[nLocal + (std::lower_bound(ghosts.begin(), ghosts.end(), u) - ghosts.begin())] = du;
+        }
+    }
+
+    bool anySubscribed(const std::vector<int>& vs) const {
+        return std::any_of(vs.begin(), vs.end(), [&](int v) { return subOffsets[v + 1] > subOffsets[v]; });
+    }
+
+    // NEXTWITH(k) on In(v) for "in-edge (u, v) alive and Dist(u) == target",
+    // a scan of the in-row from rank k; inDegree + 1 if no rank from k on qualifies
+    int nextParent(int v, int k, int target) const {
+        const int first = inOffsets[v];
+        const int last = inOffsets[v + 1];
+        for (int e = first + std::max(k, 1) - 1; e < last; ++e) {
+            if (isLive(inAlive, e) && dist[inSlot[e]] == target) {
+                return e - first + 1;
+            }
+        }
+        return last - first + 1;
+    }
+
+    // Line 7 for local v: rescan from Scan(v); false if In(v) is exhausted
+    bool rescanFrom(int v, long long& probes, long long& scanned) {
+        const int sz = inOffsets[v + 1] - inOffsets[v];
+        const int k = Scan[v];
+        Scan[v] = nextParent(v, k, dist[v] - 1);
+        ++probes;
+        scanned += std::max(0, std::min(Scan[v], sz) - k + 1);
+        return Scan[v] != sz + 1;
+    }
+
+    // Scan and Parent from Dist; every (parent, child) link to the parent's owner
+    void initScanAndTree() {
+        Scan.assign(nLocal, 0);
+        Parent.assign(nLocal, -1);
+        Tv.assign(nLocal, std::vector<int>());
+
+        long long bytes = 0;
+        mpi_exchange::Outbox<Message> out(comm, ranks);
+        #pragma omp parallel for schedule(dynamic, 256)
+        for (int v = 0; v < nLocal; ++v) {
+            const int d = dist[v];
+            if (d == 0 || d > L) {
+                continue;
+            }
+            const int pos = nextParent(v, 1, d - 1);
+            Scan[v] = pos;
+            if (pos <= inOffsets[v + 1] - inOffsets[v]) {
+                Parent[v] = inSources[inOffsets[v] + pos - 1];
+                out.push(part.owner(Parent[v]), {Attach, Parent[v], lo + v});
+            }
+        }
+        applyLinks(out.exchange(bytes));
+    }
+
+    // Detach and Attach messages for owned parents: each Tv[p] is filtered
+    // once for its detached children, then gets its new ones
+    void applyLinks(const std::vector<Message>& msgs) {
+        std::vector<std::pair<int,int>> detach;
+        for (const Message& msg : msgs) {
+            if (msg.kind == Detach) {
+                detach.emplace_back(msg.a - lo, msg.b);
+            }
+        }
+        std::sort(detach.begin(), detach.end());
+
+        const long long m = static_cast<long long>(detach.size());
+        #pragma omp parallel for schedule(dynamic, 64) if(m >= PARALLEL_THRESH)
+        for (long long j = 0; j < m; ++j) {
+            const int p = detach[j].first;
+            if (j > 0 && detach[j - 1].first == p) {
+                continue;  // not the start of p's group
+            }
+            long long end = j;
+            while (end < m && detach[end].first == p) {
+                ++end;
+            }
+            std::vector<int>& kids = Tv[p];
+            kids.erase(std::remove_if(kids.begin(), kids.end(), [&](int c) {
+                return std::binary_search(detach.begin() + j, detach.begin() + end, std::make_pair(p, c));
+            }), kids.end());
+        }
+
+        for (const Message& msg : msgs) {
+            if (msg.kind == Attach) {
+                Tv[msg.a - lo].push_back(msg.b);
+            }
+        }
+    }
+};
+
+
+#ifndef NO_DEMO_MAIN
+#include <iostream>
+
+// mpirun -np 3 ./distributed_sssp: the 6-vertex example of bfs_tree.cpp, its
+// edges dealt round-robin over the ranks, checked against bfs_array
+int main(int argc, char** argv) {
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    int me, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &me);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    const int n = 6;
+    const int L = 4;
+    std::vector<std::vector<int>> adj = {{1, 2}, {3}, {3, 4}, {5}, {5}, {}};
+    std::vector<std::pair<int,int>> all, mine;
+    for (int u = 0; u < n; ++u) {
+        for (int v : adj[u]) {
+            all.emplace_back(u, v);
+        }
+    }
+    for (size_t j = me; j < all.size(); j += ranks) {
+        mine.push_back(all[j]);
+    }
+
+    {   // ds frees its communicator, so it must go before MPI_Finalize
+        DistributedSSSP ds(MPI_COMM_WORLD, n, mine, 0, L);
+        auto report = [&](const char* what) {
+            std::vector<int> d = ds.gatherDistances(0);
+            if (me == 0) {
+                std::vector<int> want = bfs_array(adj, 0, L);
+                std::cout << what << ":";
+                for (int v = 0; v < n; ++v) {
+                    std::cout << " " << d[v];
+                }
+                std::cout << (d == want ? "  (matches BFS)" : "  (MISMATCH)") << "\n";
+            }
+        };
+        report("initial Dist");
+
+        // deletions (1,3) and (2,3), passed by rank 0 only
+        std::vector<std::pair<int,int>> batch;
+        if (me == 0) {
+            batch = {{1, 3}, {2, 3}};
+        }
+        ds.batchDelete(batch);
+        adj[1].clear();
+        adj[2] = {4};
+        report("after deleting (1,3), (2,3)");
+        if (me == 0) {
+            const DistributedSSSP::BatchStats& st = ds.lastBatchStats();
+            std::cout << "killed " << st.killed << ", tree edges " << st.treeEdges
+                      << ", supersteps " << st.supersteps << ", bytes " << st.bytesSent << "\n";
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
+#endif
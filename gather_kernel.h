@@ -0,0 +1,104 @@
+// Gather kernel shared by priority_struct_array.cpp (nextWithGather) and
+// bfs_tree.cpp (nextParentRange).
+#ifndef GATHER_KERNEL_H
+#define GATHER_KERNEL_H
+
+#include <atomic>
+#include <stdexcept>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Block kernel for NEXTWITH over contiguous values: the first i in [0, count)
+// with table[idx[i]] == target, or count.  AVX-512 tests 16 candidates per
+// step and AVX2 8, each with one gather and one compare.  The kernel is picked
+// once from what the CPU supports; setGatherKernel() overrides it at run time
+// and -DGATHER_KERNEL_SCALAR compiles the vector paths out.
+enum class GatherKernel { Scalar, AVX2, AVX512 };
+
+inline int firstGatherMatchScalar(const int* idx, int count, const int* table, int target) {
+    for (int i = 0; i < count; ++i) {
+        if (table[idx[i]] == target) {
+            return i;
+        }
+    }
+    return count;
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(GATHER_KERNEL_SCALAR)
+#define GATHER_KERNEL_X86 1
+
+__attribute__((target("avx2")))
+inline int firstGatherMatchAVX2(const int* idx, int count, const int* table, int target) {
+    const __m256i t = _mm256_set1_epi32(target);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i ix = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + i));
+        __m256i d  = _mm256_i32gather_epi32(table, ix, 4);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(d, t)));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + firstGatherMatchScalar(idx + i, count - i, table, target);
+}
+
+__attribute__((target("avx512f")))
+inline int firstGatherMatchAVX512(const int* idx, int count, const int* table, int target) {
+    const __m512i t = _mm512_set1_epi32(target);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i ix = _mm512_loadu_si512(idx + i);
+        __m512i d  = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, ix, table, 4);
+        __mmask16 mask = _mm512_cmpeq_epi32_mask(d, t);
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + firstGatherMatchScalar(idx + i, count - i, table, target);
+}
+#endif
+
+inline bool gatherKernelSupported(GatherKernel k) {
+#ifdef GATHER_KERNEL_X86
+    __builtin_cpu_init();
+    switch (k) {
+        case GatherKernel::AVX512: return __builtin_cpu_supports("avx512f");
+        case GatherKernel::AVX2:   return __builtin_cpu_supports("avx2");
+        default:                   return true;
+    }
+#else
+    return k == GatherKernel::Scalar;
+#endif
+}
+
+inline std::atomic<GatherKernel>& gatherKernelChoice() {
+    static std::atomic<GatherKernel> choice{
+        gatherKernelSupported(GatherKernel::AVX512) ? GatherKernel::AVX512 :
+        gatherKernelSupported(GatherKernel::AVX2)   ? GatherKernel::AVX2   :
+                                                      GatherKernel::Scalar};
+    return choice;
+}
+
+inline GatherKernel gatherKernel() {
+    return gatherKernelChoice().load(std::memory_order_relaxed);
+}
+
+inline void setGatherKernel(GatherKernel k) {
+    if (!gatherKernelSupported(k)) {
+        throw std::logic_error("setGatherKernel: kernel not supported on this CPU");
+    }
+    gatherKernelChoice().store(k, std::memory_order_relaxed);
+}
+
+inline int firstGatherMatch(const int* idx, int count, const int* table, int target) {
+    switch (gatherKernel()) {
+#ifdef GATHER_KERNEL_X86
+        case GatherKernel::AVX512: return firstGatherMatchAVX512(idx, count, table, target);
+        case GatherKernel::AVX2:   return firstGatherMatchAVX2(idx, count, table, target);
+#endif
+        default:                   return firstGatherMatchScalar(idx, count, table, target);
+    }
+}
+
+#endif // GATHER_KERNEL_H
@@ -0,0 +1,378 @@
+// Edge-list input for the Theorem 1.2 structures.
+//
+// loadEdgeList maps an edge-list file and builds Out and its reverse Rev
+// directly, in two counting passes over the mapping: the first counts out-
+// and in-degrees, a prefix sum turns them into row offsets, and the second
+// writes every edge into both rows.  Each pass parses the file in parallel, in
+// chunks cut at line (or pair) boundaries, so the edges are never held as a list.
+// EdgeBatchStream reads deletion (or insertion) batches from a file the same way.
+//
+// Formats:
+//   Text    one "u v" per line, anything after v ignored (weights); lines
+//           starting with '#' or '%' are comments.  In a batch stream an
+//           empty line ends the current batch.
+//   Binary  native-endian int32 pairs u, v with no header.
+//
+// CSRGraph and parallelPrefixSum come from bfs_tree.cpp, placed ahead of this
+// file in the build.
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <cstdlib>
+#include <exception>
+#include <omp.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum class EdgeFormat { Text, Binary };
+
+// A file mapped read-only for the lifetime of the object
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) : path(path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::logic_error("cannot open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::logic_error("cannot stat " + path);
+        }
+        len = static_cast<size_t>(st.st_size);
+        if (len > 0) {
+            void* p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::logic_error("cannot map " + path);
+            }
+            base = static_cast<const char*>(p);
+            ::madvise(p, len, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (base) {
+            ::munmap(const_cast<char*>(base), len);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return base; }
+    size_t size() const { return len; }
+    const std::string& name() const { return path; }
+
+private:
+    std::string path;
+    const char* base = nullptr;
+    size_t len = 0;
+};
+
+
+namespace edge_io {
+
+// aim for chunks of about this many bytes, but at least a few per thread
+constexpr size_t CHUNK_BYTES = size_t(1) << 22;
+
+// Parse one text line starting at p (p < end): sets u, v and returns true for
+// an edge line, false for a blank or comment line.  p is left past the line.
+// Throws on a line that is neither.
+inline bool parseLine(const char*& p, const char* end, int& u, int& v, const MappedFile& file) {
+    const char* line = p;
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+
+    bool edge = false;
+    if (p < end && *p != '\n' && *p != '#' && *p != '%') {
+        long long x[2];
+        for (int i = 0; i < 2; ++i) {
+            while (p < end && (*p == ' ' || *p == '\t')) ++p;
+            if (p == end || *p < '0' || *p > '9') {
+                x[i] = -1;
+                break;
+            }
+            x[i] = 0;
+            while (p < end && *p >= '0' && *p <= '9' && x[i] <= INT_MAX) {
+                x[i] = 10 * x[i] + (*p++ - '0');
+            }
+        }
+        if (x[0] < 0 || x[1] < 0 || x[0] >= INT_MAX || x[1] >= INT_MAX ||
+            (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')) {
+            const char* eol = static_cast<const char*>(std::memchr(line, '\n', end - line));
+            throw std::logic_error("bad edge line in " + file.name() + ": " +
+                                   std::string(line, eol ? eol : end));
+        }
+        u = static_cast<int>(x[0]);
+        v = static_cast<int>(x[1]);
+        edge = true;
+    }
+
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    p = eol ? eol + 1 : end;
+    return edge;
+}
+
+// Chunk f.size() bytes (text) or pairs (binary) for the team; text chunk
+// boundaries are moved forward to the start of a line.
+inline std::vector<size_t> chunkBounds(const MappedFile& f, EdgeFormat fmt) {
+    const size_t units = (fmt == EdgeFormat::Text) ? f.size() : f.size() / 8;
+    const size_t unitBytes = (fmt == EdgeFormat::Text) ? 1 : 8;
+    size_t chunks = std::max<size_t>(1, units * unitBytes / CHUNK_BYTES);
+    chunks = std::max<size_t>(chunks, std::min<size_t>(4 * omp_get_max_threads(), units / 4096 + 1));
+
+    std::vector<size_t> b(chunks + 1);
+    for (size_t c = 0; c <= chunks; ++c) {
+        b[c] = units * c / chunks;
+        if (fmt == EdgeFormat::Text && c > 0 && c < chunks) {
+            const char* d = f.data();
+            size_t x = std::max(b[c], b[c - 1]);
+            while (x > 0 && x < units && d[x - 1] != '\n') ++x;
+            b[c] = x;
+        }
+    }
+    return b;
+}
+
+// f(u, v) for every edge of the file, chunks in parallel; u == v included
+template <typename F>
+void forEachEdge(const MappedFile& file, EdgeFormat fmt, const std::vector<size_t>& bounds, F&& f) {
+    const long long chunks = static_cast<long long>(bounds.size()) - 1;
+    const char* d = file.data();
+
+    // the first exception of the team, rethrown after the loop
+    std::exception_ptr error;
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long long c = 0; c < chunks; ++c) {
+        try {
+            if (fmt == EdgeFormat::Text) {
+                const char* p = d + bounds[c];
+                const char* end = d + bounds[c + 1];
+                int u, v;
+                while (p < end) {
+                    if (parseLine(p, end, u, v, file)) {
+                        f(u, v);
+                    }
+                }
+            } else {
+                for (size_t j = bounds[c]; j < bounds[c + 1]; ++j) {
+                    int32_t pair[2];
+                    std::memcpy(pair, d + 8 * j, 8);
+                    if (pair[0] < 0 || pair[1] < 0 || pair[0] == INT_MAX || pair[1] == INT_MAX) {
+                        throw std::logic_error("bad vertex id in " + file.name() +
+                                               " at pair " + std::to_string(j));
+                    }
+                    f(pair[0], pair[1]);
+                }
+            }
+        } catch (...) {
+            #pragma omp critical(edge_io_error)
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Sort every row, drop repeated targets, and close the gaps.
+inline void compactRows(CSRGraph& g) {
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (int v = 0; v < g.numVertices(); ++v) {
+        std::sort(g.targets.begin() + g.offsets[v], g.targets.begin() + g.offsets[v + 1]);
+    }
+    g.compactRows();
+}
+
+} // namespace edge_io
+
+
+// Out and Rev (= Out.transpose()) of an edge-list file, ready for SharedGraph
+struct EdgeListGraph {
+    CSRGraph out;
+    CSRGraph rev;
+};
+
+// Self-loops and repeated edges are dropped.  n is max id + 1 unless
+// numVertices is given, which saves a pass; ids >= numVertices are an error.
+inline EdgeListGraph loadEdgeList(const std::string& path, EdgeFormat fmt = EdgeFormat::Text,
+                                  int numVertices = 0) {
+    MappedFile file(path);
+    if (fmt == EdgeFormat::Binary && file.size() % 8 != 0) {
+        throw std::logic_error(path + ": size is not a multiple of 8 bytes (int32 pairs)");
+    }
+    const std::vector<size_t> bounds = edge_io::chunkBounds(file, fmt);
+
+    int n = numVertices;
+    if (n <= 0) {
+        int maxId = -1;
+        edge_io::forEachEdge(file, fmt, bounds, [&](int u, int v) {
+            int x = std::max(u, v);
+            int seen = __atomic_load_n(&maxId, __ATOMIC_RELAXED);
+            while (x > seen &&
+                   !__atomic_compare_exchange_n(&maxId, &seen, x, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            }
+        });
+        n = maxId + 1;
+    }
+
+    EdgeListGraph g;
+    for (CSRGraph* c : {&g.out, &g.rev}) {
+        c->n = n;
+        c->offsets.assign(n + 1, 0);
+    }
+
+    // pass 1: out- and in-degrees, shifted by one for the prefix sum
+    edge_io::forEachEdge(file, fmt, bounds, [&](int u, int v) {
+        if (u >= n || v >= n) {
+            throw std::out_of_range("vertex id out of range in " + path);
+        }
+        if (u == v) return;
+        __atomic_fetch_add(&g.out.offsets[u + 1], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&g.rev.offsets[v + 1], 1, __ATOMIC_RELAXED);
+    });
+    long long m = 0;
+    #pragma omp parallel for reduction(+:m)
+    for (int v = 1; v <= n; ++v) {
+        m += g.out.offsets[v];
+    }
+    if (m > INT_MAX) {
+        throw std::out_of_range(path + ": more edges than an int edge id can hold");
+    }
+    parallelPrefixSum(g.out.offsets);
+    parallelPrefixSum(g.rev.offsets);
+
+    // pass 2: each edge goes to the next free slot of its row in both graphs
+    g.out.targets.resize(m);
+    g.rev.targets.resize(m);
+    {
+        std::vector<int> outFill(g.out.offsets.begin(), g.out.offsets.end() - 1);
+        std::vector<int> revFill(g.rev.offsets.begin(), g.rev.offsets.end() - 1);
+        edge_io::forEachEdge(file, fmt, bounds, [&](int u, int v) {
+            if (u == v) return;
+            g.out.targets[__atomic_fetch_add(&outFill[u], 1, __ATOMIC_RELAXED)] = v;
+            g.rev.targets[__atomic_fetch_add(&revFill[v], 1, __ATOMIC_RELAXED)] = u;
+        });
+    }
+
+    // both sides hold the same multiset of pairs, so they dedup to transposes
+    edge_io::compactRows(g.out);
+    edge_io::compactRows(g.rev);
+    return g;
+}
+
+
+// Batches of edges read in order from a mapped edge-list file, for streaming
+// deletions (or insertions) into DynamicSSSP.  A batch ends after maxEdges
+// edges, at an empty line (text), or at the end of the file.
+class EdgeBatchStream {
+public:
+    explicit EdgeBatchStream(const std::string& path, EdgeFormat fmt = EdgeFormat::Text)
+        : file(path), fmt(fmt), pos(0) {
+        if (fmt == EdgeFormat::Binary && file.size() % 8 != 0) {
+            throw std::logic_error(path + ": size is not a multiple of 8 bytes (int32 pairs)");
+        }
+    }
+
+    bool done() const {
+        return pos >= file.size();
+    }
+
+    // the next batch; empty only once the file is exhausted
+    std::vector<std::pair<int,int>> next(size_t maxEdges) {
+        std::vector<std::pair<int,int>> batch;
+        const char* d = file.data();
+        const char* end = d + file.size();
+
+        if (fmt == EdgeFormat::Binary) {
+            size_t count = std::min(maxEdges, (file.size() - pos) / 8);
+            batch.resize(count);
+            for (size_t j = 0; j < count; ++j) {
+                int32_t pair[2];
+                std::memcpy(pair, d + pos + 8 * j, 8);
+                batch[j] = {pair[0], pair[1]};
+            }
+            pos += 8 * count;
+            return batch;
+        }
+
+        while (pos < file.size() && batch.size() < maxEdges) {
+            const char* p = d + pos;
+            const char* q = p;
+            while (q < end && (*q == ' ' || *q == '\t' || *q == '\r')) ++q;
+            const bool blank = (q == end || *q == '\n');
+            int u, v;
+            bool edge = edge_io::parseLine(p, end, u, v, file);
+            pos = p - d;
+            if (edge) {
+                batch.push_back({u, v});
+            } else if (blank && !batch.empty()) {
+                break;
+            }
+        }
+        return batch;
+    }
+
+private:
+    MappedFile file;
+    EdgeFormat fmt;
+    size_t pos;
+};
+
+
+#ifndef NO_DEMO_MAIN
+#include <iostream>
+#include <cstdio>
+
+int main() {
+    // the 6-vertex example of bfs_tree.cpp, with a comment, a weight column,
+    // a self-loop and a repeated edge
+    char path[] = "/tmp/graph_io_demoXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return 1;
+    }
+    const char text[] = "# u v [w]\n0 1\n0 2 7\n1 3\n2 3\n2 4\n3 5\n3 3\n0 1\n";
+    if (::write(fd, text, sizeof(text) - 1) != static_cast<ssize_t>(sizeof(text) - 1)) {
+        return 1;
+    }
+    ::close(fd);
+
+    EdgeListGraph g = loadEdgeList(path);
+    std::cout << "n = " << g.out.numVertices() << ", m = " << g.out.numEdges() << "\n";
+    for (int v = 0; v < g.out.numVertices(); ++v) {
+        std::cout << "  " << v << ": out";
+        g.out.forEachNeighbor(v, [](int u) { std::cout << " " << u; });
+        std::cout << " | in";
+        g.rev.forEachNeighbor(v, [](int u) { std::cout << " " << u; });
+        std::cout << "\n";
+    }
+
+    // two deletion batches separated by an empty line
+    const char batches[] = "2 3\n\n0 1\n1 3\n";
+    FILE* out = std::fopen(path, "w");
+    std::fputs(batches, out);
+    std::fclose(out);
+
+    EdgeBatchStream stream(path);
+    for (int b = 0; !stream.done(); ++b) {
+        std::cout << "batch " << b << ":";
+        for (auto [u, v] : stream.next(100)) {
+            std::cout << " (" << u << "," << v << ")";
+        }
+        std::cout << "\n";
+    }
+    std::remove(path);
+    return 0;
+}
+#endif
@@ -0,0 +1,222 @@
+// Counter registry shared by the PriorityStructure variants, bfs_tree.cpp and
+// distributed_sssp.cpp.
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <array>
+#include <mutex>
+#include <algorithm>
+#include <omp.h>
+
+// **COUNTERS**
+// Optional hot-path instrumentation for PriorityStructure and DynamicSSSP.
+// Compiled out unless PS_ENABLE_COUNTERS is defined: add() and PerfTimer are
+// then empty and the call sites vanish.  Each thread counts into its own
+// cache-line aligned slot; snapshot() sums the slots, reset() zeroes them
+// (call it between operations, not during one).
+enum class Counter : int {
+    QueryCalls,         // QUERY(k)
+    QueryDepth,         // tree levels walked by queryByRank
+    FindCalls,          // FIND(p)
+    FindDepth,          // tree levels walked by findByPriority
+    NodesAllocated,     // arena allocations
+    NextWithCalls,      // NEXTWITH(k, f)
+    NextWithPhases,     // doubling phases run by NEXTWITH
+    NextWithProbes,     // root-to-leaf descents (cursor positionings) for NEXTWITH
+    PredicateEvals,     // f(QUERY(j)) evaluations
+    GatherRanks,        // In(v) ranks handed to the gather kernel by nextParent
+    RepairBatches,      // DynamicSSSP::repair calls
+    RepairPhases,       // phases i of Algorithm 1 actually run
+    Reparented,         // rescans that found a new parent
+    PushedNext,         // vertices pushed to the next level's U
+    InsertBatches,      // DynamicSSSP::relax calls
+    Lowered,            // vertices whose Dist dropped in relax
+    SplitRescans,       // repair rescans run as a task split into rank ranges
+    SplitFanouts,       // repair child fan-outs split into tasks
+    PathSerial,         // nextWith/nextWithRange: cursor walk on the calling thread
+    PathTasksInTeam,    // ... tasks in an enclosing parallel region
+    PathNewTeam,        // ... tasks in a freshly opened parallel region
+    COUNT
+};
+
+enum class Timer : int {
+    InitBFS,            // Lemma 3.2: initial bfs_array
+    DeleteEdges,        // marking the batch dead
+    FirstPass,          // Algorithm 1 lines 1-2: find and detach deleted tree edges
+    SecondPass,         // line 3: rescan for the orphaned endpoints
+    Rescan,             // lines 6-12: rescans of U and the orphan bucket
+    Advance,            // lines 13-15: U <- U', Dist <- i + 1
+    Publish,            // reader snapshot
+    InsertEdges,        // making an insertion batch live
+    Lower,              // relax: bounded BFS over the lowered vertices
+    COUNT
+};
+
+class PerfCounters {
+public:
+#ifdef PS_ENABLE_COUNTERS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    static constexpr int NUM_COUNTERS = static_cast<int>(Counter::COUNT);
+    static constexpr int NUM_TIMERS   = static_cast<int>(Timer::COUNT);
+    static constexpr int MAX_PHASES   = 64;   // |U| of phase >= MAX_PHASES-1 goes to the last entry
+
+    static void add(Counter c, long long d = 1) {
+        if constexpr (enabled) {
+            bump(slot().count[static_cast<int>(c)], d);
+        }
+    }
+
+    static void addTime(Timer t, double seconds) {
+        if constexpr (enabled) {
+            bump(slot().nanos[static_cast<int>(t)], static_cast<long long>(seconds * 1e9));
+        }
+    }
+
+    // |U| at the start of phase i of one repair
+    static void addPhaseU(int i, long long u) {
+        if constexpr (enabled) {
+            bump(slot().phaseU[std::min(i, MAX_PHASES - 1)], u);
+        }
+    }
+
+    struct Snapshot {
+        std::array<long long, NUM_COUNTERS> count{};
+        std::array<long long, NUM_TIMERS>   nanos{};
+        std::array<long long, MAX_PHASES>   phaseU{};   // summed over repairs
+
+        long long operator[](Counter c) const { return count[static_cast<int>(c)]; }
+        double seconds(Timer t) const { return nanos[static_cast<int>(t)] * 1e-9; }
+
+        std::string toJSON() const {
+            std::string out = "{\n  \"enabled\": ";
+            out += enabled ? "true" : "false";
+            out += ",\n  \"counters\": {";
+            for (int c = 0; c < NUM_COUNTERS; ++c) {
+                out += (c ? ", " : "") + quote(counterName(static_cast<Counter>(c))) +
+                       ": " + std::to_string(count[c]);
+            }
+            out += "},\n  \"seconds\": {";
+            for (int t = 0; t < NUM_TIMERS; ++t) {
+                out += (t ? ", " : "") + quote(timerName(static_cast<Timer>(t))) +
+                       ": " + std::to_string(nanos[t] * 1e-9);
+            }
+            out += "},\n  \"phase_U\": [";
+            int last = MAX_PHASES;
+            while (last > 0 && phaseU[last - 1] == 0) --last;
+            for (int i = 0; i < last; ++i) {
+                out += (i ? ", " : "") + std::to_string(phaseU[i]);
+            }
+            out += "]\n}\n";
+            return out;
+        }
+    };
+
+    static Snapshot snapshot() {
+        Snapshot S;
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (const auto& p : registry()) {
+            for (int c = 0; c < NUM_COUNTERS; ++c) S.count[c]  += load(p->count[c]);
+            for (int t = 0; t < NUM_TIMERS; ++t)   S.nanos[t]  += load(p->nanos[t]);
+            for (int i = 0; i < MAX_PHASES; ++i)   S.phaseU[i] += load(p->phaseU[i]);
+        }
+        return S;
+    }
+
+    static void reset() {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (const auto& p : registry()) {
+            for (auto& x : p->count)  __atomic_store_n(&x, 0, __ATOMIC_RELAXED);
+            for (auto& x : p->nanos)  __atomic_store_n(&x, 0, __ATOMIC_RELAXED);
+            for (auto& x : p->phaseU) __atomic_store_n(&x, 0, __ATOMIC_RELAXED);
+        }
+    }
+
+    static const char* counterName(Counter c) {
+        static const char* names[NUM_COUNTERS] = {
+            "query_calls", "query_depth", "find_calls", "find_depth", "nodes_allocated",
+            "nextwith_calls", "nextwith_phases", "nextwith_probes", "predicate_evals",
+            "gather_ranks", "repair_batches", "repair_phases", "reparented", "pushed_next",
+            "insert_batches", "lowered", "split_rescans", "split_fanouts",
+            "path_serial", "path_tasks_in_team", "path_new_team"};
+        return names[static_cast<int>(c)];
+    }
+
+    static const char* timerName(Timer t) {
+        static const char* names[NUM_TIMERS] = {
+            "init_bfs", "delete_edges", "first_pass", "second_pass",
+            "rescan", "advance", "publish", "insert_edges", "lower"};
+        return names[static_cast<int>(t)];
+    }
+
+private:
+    // written only by its owner thread; relaxed atomics so snapshot() may read it
+    struct alignas(64) Slot {
+        long long count[NUM_COUNTERS] = {};
+        long long nanos[NUM_TIMERS] = {};
+        long long phaseU[MAX_PHASES] = {};
+    };
+
+    static void bump(long long& x, long long d) {
+        __atomic_store_n(&x, __atomic_load_n(&x, __ATOMIC_RELAXED) + d, __ATOMIC_RELAXED);
+    }
+
+    static long long load(const long long& x) {
+        return __atomic_load_n(&x, __ATOMIC_RELAXED);
+    }
+
+    static std::string quote(const char* s) {
+        return std::string("\"") + s + "\"";
+    }
+
+    // slots are never freed, so counts of finished threads still add up
+    static Slot& slot() {
+        thread_local Slot* mine = [] {
+            std::lock_guard<std::mutex> lock(registryMutex());
+            registry().push_back(std::make_unique<Slot>());
+            return registry().back().get();
+        }();
+        return *mine;
+    }
+
+    static std::vector<std::unique_ptr<Slot>>& registry() {
+        static std::vector<std::unique_ptr<Slot>> slots;
+        return slots;
+    }
+
+    static std::mutex& registryMutex() {
+        static std::mutex m;
+        return m;
+    }
+};
+
+// adds the lifetime of the enclosing scope to a Timer (nothing when compiled out)
+class PerfTimer {
+public:
+    explicit PerfTimer(Timer t) : timer(t) {
+        if constexpr (PerfCounters::enabled) {
+            start = omp_get_wtime();
+        }
+    }
+
+    ~PerfTimer() {
+        if constexpr (PerfCounters::enabled) {
+            PerfCounters::addTime(timer, omp_get_wtime() - start);
+        }
+    }
+
+    PerfTimer(const PerfTimer&) = delete;
+    PerfTimer& operator=(const PerfTimer&) = delete;
+
+private:
+    Timer timer;
+    double start = 0;
+};
+
+#endif // PERF_COUNTERS_H
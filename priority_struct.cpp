@@ -4,7 +4,12 @@
 #include <iostream>
 #include <string>
 #include <algorithm>
+#include <memory>
+#include <array>
+#include <atomic>
+#include <utility>
 #include <omp.h>
+#include "perf_counters.h"
 
 template <typename T>
 class PriorityStructure {
@@ -12,11 +17,34 @@ public:
     explicit PriorityStructure(int maxPriority)
         : maxP(maxPriority), root(nullptr) {}
 
+    // nodes belong to the arena, so a structure can be moved but not copied
+    PriorityStructure(const PriorityStructure&) = delete;
+    PriorityStructure& operator=(const PriorityStructure&) = delete;
+
+    PriorityStructure(PriorityStructure&& other) noexcept
+        : maxP(other.maxP), root(other.root), arena(std::move(other.arena)) {
+        other.root = nullptr;
+    }
+
+    PriorityStructure& operator=(PriorityStructure&& other) noexcept {
+        if (this != &other) {
+            maxP  = other.maxP;
+            root  = other.root;
+            arena = std::move(other.arena);
+            other.root = nullptr;
+        }
+        return *this;
+    }
+
+    // the arena releases every node in one shot
+    ~PriorityStructure() = default;
+
     // **API FUNCTION**
     // INITIALIZE({(v1, p1), ..., (vl, pl)})
     // initialize segment tree from list of (value, priority) pairs
     void initialize(const std::vector<std::pair<T,int>>& elems) {
-        // TODO: in case we ever call initialize multiple times, need to delete original tree
+        // drop any previous tree in one shot
+        arena.clear();
         root = nullptr;
 
         if (elems.empty()) {
@@ -31,11 +59,15 @@ public:
                 });
 
 
-        #pragma omp parallel
+        // tasks only in the top levels, about one subtree per thread; each task
+        // builds into its own arena, so this one only needs the part kept here
+        const int maxParallelDepth = parallelDepthFor(omp_get_max_threads());
+        arena.reserve(nodeHint(static_cast<int>(items.size()) >> maxParallelDepth, 1, maxP));
+        #pragma omp parallel if(maxParallelDepth > 0)
         {
             #pragma omp single
             {
-                root = buildFromSorted(items, 0, items.size(), 1, maxP);
+                root = buildFromSorted(items, 0, items.size(), 1, maxP, 0, maxParallelDepth, arena);
             }
         }
     }
@@ -121,7 +153,32 @@ public:
         if (p < 1) p = 1;
         if (p > n) return n + 1;
 
+        int cutoff = serialCutoff();
         int i = 0;
+
+        // Phases shorter than the cutoff: one cursor walks QUERY(p), QUERY(p+1), ...
+        // across the phase boundaries, amortized O(1) per rank and no OpenMP at all.
+        if (cutoff > 1) {
+            PerfCounters::add(Counter::PathSerial);
+            RankCursor c = cursor(p);
+
+            while (p <= n && (1 << i) < cutoff) {
+                int len = 1 << i;         // 2^i
+                int end = p + len - 1;
+                if (end > n) end = n;
+
+                // Phase i: scan QUERY(p), ..., QUERY(end)
+                for (; c.valid() && c.rank() <= end; c.next()) {
+                    if (f(c.value())) {
+                        return c.rank();
+                    }
+                }
+
+                p += len; // advance start by 2^i
+                ++i;
+            }
+        }
+
         while (p <= n) {
             int len = 1 << i;         // 2^i
             int end = p + len - 1;
@@ -141,33 +198,58 @@ public:
         return n + 1;
     }
 
-    
+    // smallest j in [L, R] with f(QUERY(j)), or size() + 1.
+    // Ranges below serialCutoff() are scanned serially; larger ones as tasks,
+    // inside the caller's team if there is one, otherwise in a new team.
     int nextWithRange(int L, int R, const std::function<bool(const T&)>& f) const {
         int n = size();
         if (n == 0) {
             return 1;
         }
 
-        // // Clamp range
-        // if (max > n)  max = n;
-        // if (min > max) {
-        //     return n + 1;
-        // }
+        // Clamp range
+        if (L < 1) L = 1;
+        if (R > n) R = n;
+        if (L > R) {
+            return n + 1;
+        }
 
-        int best = n + 1;
+        long long len = static_cast<long long>(R) - L + 1;
 
-        // Parallel loop over j in [L, R].
-        #pragma omp parallel for reduction(min:best)
-        for (int j = L; j <= R; ++j) {
-            const T& val = query(j);
-            if (f(val) && j < best) {
-                best = j;
-            }
+        if (len < serialCutoff() ||
+            (omp_in_parallel() ? omp_get_num_threads() : omp_get_max_threads()) == 1) {
+            PerfCounters::add(Counter::PathSerial);
+            return scanSerial(L, R, f);
         }
 
+        if (omp_in_parallel()) {
+            PerfCounters::add(Counter::PathTasksInTeam);
+            return scanWithTasks(L, R, f);
+        }
+
+        PerfCounters::add(Counter::PathNewTeam);
+        int best = n + 1;
+        #pragma omp parallel
+        {
+            #pragma omp single
+            {
+                best = scanWithTasks(L, R, f);
+            }
+        }
         return best;
     }
 
+    // **EXECUTION POLICY**
+    // range length from which nextWith/nextWithRange go parallel (class-wide);
+    // the path each call takes is counted in Counter::Path* (PS_ENABLE_COUNTERS)
+    static int serialCutoff() {
+        return cutoffLen.load(std::memory_order_relaxed);
+    }
+
+    static void setSerialCutoff(int len) {
+        cutoffLen.store(std::max(len, 1), std::memory_order_relaxed);
+    }
+
 
 private:
     struct Node {
@@ -180,13 +262,178 @@ private:
         Node() : cnt(0), present(false), left(nullptr), right(nullptr) {}
     };
 
+    // Slab allocator for Node.  Slabs grow geometrically and never move, and
+    // released nodes go on a free list threaded through `left`.  Not thread-safe:
+    // a parallel build task fills its own arena, which the parent absorbs after
+    // the taskwait.
+    class NodeArena {
+    public:
+        NodeArena() = default;
+        NodeArena(const NodeArena&) = delete;
+        NodeArena& operator=(const NodeArena&) = delete;
+
+        NodeArena(NodeArena&& other) noexcept {
+            *this = std::move(other);
+        }
+
+        NodeArena& operator=(NodeArena&& other) noexcept {
+            slabs    = std::move(other.slabs);
+            current  = std::exchange(other.current, nullptr);
+            used     = std::exchange(other.used, 0);
+            slabSize = std::exchange(other.slabSize, 0);
+            freeList = std::exchange(other.freeList, nullptr);
+            other.slabs.clear();
+            return *this;
+        }
+
+        // make sure the current slab has room for `count` more nodes
+        void reserve(int count) {
+            if (slabSize - used < count) {
+                addSlab(std::max(count, MIN_SLAB));
+            }
+        }
+
+        Node* alloc() {
+            if (freeList) {
+                Node* node = freeList;
+                freeList = node->left;
+                *node = Node();
+                return node;
+            }
+            if (used == slabSize) {
+                addSlab(std::min(std::max(2 * slabSize, MIN_SLAB), MAX_SLAB));
+            }
+            return &current[used++];
+        }
+
+        void release(Node* node) {
+            node->left = freeList;
+            freeList = node;
+        }
+
+        // take over every slab and free node of `other`
+        void absorb(NodeArena& other) {
+            for (auto& slab : other.slabs) {
+                slabs.push_back(std::move(slab));
+            }
+            // keep bumping from whichever slab has more room left
+            if (other.slabSize - other.used > slabSize - used) {
+                current  = other.current;
+                used     = other.used;
+                slabSize = other.slabSize;
+            }
+            while (other.freeList) {
+                Node* node = other.freeList;
+                other.freeList = node->left;
+                release(node);
+            }
+            other.slabs.clear();
+            other.current = nullptr;
+            other.used = other.slabSize = 0;
+        }
+
+        void clear() {
+            slabs.clear();
+            current = nullptr;
+            used = slabSize = 0;
+            freeList = nullptr;
+        }
+
+    private:
+        static constexpr int MIN_SLAB = 16;
+        static constexpr int MAX_SLAB = 1 << 16;
+
+        std::vector<std::unique_ptr<Node[]>> slabs;
+        Node* current  = nullptr;   // slab we bump-allocate from
+        int used       = 0;
+        int slabSize   = 0;
+        Node* freeList = nullptr;
+
+        void addSlab(int count) {
+            slabs.push_back(std::make_unique<Node[]>(count));
+            current  = slabs.back().get();
+            used     = 0;
+            slabSize = count;
+        }
+    };
+
+    static inline std::atomic<int> cutoffLen{2048};
+
+    // cursor walk of [L, R] on the calling thread
+    int scanSerial(int L, int R, const std::function<bool(const T&)>& f) const {
+        for (RankCursor c = cursor(L); c.valid() && c.rank() <= R; c.next()) {
+            if (f(c.value())) {
+                return c.rank();
+            }
+        }
+        return size() + 1;
+    }
+
+    // split [L, R] into chunks of at least serialCutoff() ranks, one task each;
+    // must be called from inside a parallel region
+    int scanWithTasks(int L, int R, const std::function<bool(const T&)>& f) const {
+        std::atomic<int> best(size() + 1);
+
+        long long len = static_cast<long long>(R) - L + 1;
+        long long byCutoff = (len + serialCutoff() - 1) / serialCutoff();
+        int chunks = static_cast<int>(std::min<long long>(4LL * omp_get_num_threads(), byCutoff));
+
+        #pragma omp taskgroup
+        {
+            for (int t = 0; t < chunks; ++t) {
+                int lo = L + static_cast<int>(len * t / chunks);
+                int hi = L + static_cast<int>(len * (t + 1) / chunks) - 1;
+
+                #pragma omp task firstprivate(lo, hi) shared(best, f)
+                {
+                    // chunks past an already found match have nothing to contribute
+                    for (RankCursor c = cursor(lo);
+                         c.valid() && c.rank() <= hi &&
+                         c.rank() < best.load(std::memory_order_relaxed);
+                         c.next()) {
+                        if (f(c.value())) {
+                            int cur = best.load(std::memory_order_relaxed);
+                            while (c.rank() < cur &&
+                                   !best.compare_exchange_weak(cur, c.rank(),
+                                                               std::memory_order_relaxed)) {
+                            }
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        return best.load(std::memory_order_relaxed);
+    }
+
     int maxP;           // max priority
     Node* root;         // root
+    NodeArena arena;    // owns every node of the tree
+
+    // rough node count for a tree over [L, R] holding `count` elements:
+    // ~2 * count for the branching part plus one chain of depth log2(R - L + 1)
+    static int nodeHint(int count, int L, int R) {
+        int depth = 1;
+        while ((1LL << (depth - 1)) < static_cast<long long>(R) - L + 1) {
+            ++depth;
+        }
+        return 2 * count + depth;
+    }
+
+    // levels of the build that spawn tasks: 2^depth >= numThreads
+    static int parallelDepthFor(int numThreads) {
+        int depth = 0;
+        while ((1 << depth) < numThreads) {
+            ++depth;
+        }
+        return depth;
+    }
 
     // create node if null
-    static void ensureNode(Node*& node) {
+    void ensureNode(Node*& node) {
         if (!node) {
-            node = new Node();
+            node = arena.alloc();
         }
     }
 
@@ -216,13 +463,15 @@ private:
     // recurse over nodes "node" which span interval ["L", "R"]
     T erase(Node*& node, int L, int R, int k) {
 
-        node->cnt -= 1; // TODO: if we ever reach a node with count 0, we can delete the whole thing to save memory
-                        // Pass down pointer to the node where cnt switched from >1 to =1
+        node->cnt -= 1;
 
-        // base case -- reached leaf
-        if (L == R) {
-            node->present = false;
-            return node->value;
+        // Last element below this node: the subtree is a single root-to-leaf
+        // chain, so take the value and hand the whole chain back to the arena.
+        // (This also covers the leaf itself.)
+        if (node->cnt == 0) {
+            T v = releaseChain(node);
+            node = nullptr;
+            return v;
         }
 
         int mid = (L + R) / 2;
@@ -236,6 +485,18 @@ private:
         }
     }
 
+    // release a subtree holding exactly one element, return that element's value
+    T releaseChain(Node* node) {
+        while (node->left || node->right) {
+            Node* next = (node->left ? node->left : node->right);
+            arena.release(node);
+            node = next;
+        }
+        T v = node->value;
+        arena.release(node);
+        return v;
+    }
+
     // is there an element with priority p?
     // recurse over nodes "node" which span interval ["L", "R"]
     bool presentPriority(Node* node, int L, int R, int p) const {
@@ -259,13 +520,15 @@ private:
 
     Node* buildFromSorted(const std::vector<std::pair<T,int>>& items,
                       int start, int end, // indices spanned by items
-                      int L, int R) { // interval spanned by this node
+                      int L, int R,   // interval spanned by this node
+                      int depth, int maxParallelDepth,
+                      NodeArena& pool) { // arena of the calling task
         
         if (start >= end) { // Error
             return nullptr;
         }
 
-        Node* node = new Node();
+        Node* node = pool.alloc();
         node->cnt = end - start;  // number of elements in this subtree
 
         if (L == R) {
@@ -292,19 +555,28 @@ private:
         bool hasLeft  = (start < m);
         bool hasRight = (m < end);
 
-        if (hasLeft && hasRight) { // recurse tree-like, spawn new task
-            #pragma omp task shared(leftChild)
+        if (hasLeft && hasRight && depth < maxParallelDepth) { // recurse tree-like, spawn new task
+            // the task gets its own arena, absorbed after the taskwait;
+            // items is a reference and must be shared, or each task copies it
+            NodeArena taskPool;
+            #pragma omp task shared(leftChild, taskPool, items)
             {
-                leftChild = buildFromSorted(items, start, m, L, mid);
+                taskPool.reserve(nodeHint((m - start) >> (maxParallelDepth - depth - 1), L, mid));
+                leftChild = buildFromSorted(items, start, m, L, mid,
+                                            depth + 1, maxParallelDepth, taskPool);
             }
-            rightChild = buildFromSorted(items, m, end, mid + 1, R);
+            rightChild = buildFromSorted(items, m, end, mid + 1, R,
+                                         depth + 1, maxParallelDepth, pool);
             #pragma omp taskwait
-        } else { // recurse linearly
+            pool.absorb(taskPool);
+        } else { // recurse linearly, into the caller's arena
             if (hasLeft) {
-                leftChild = buildFromSorted(items, start, m, L, mid);
+                leftChild = buildFromSorted(items, start, m, L, mid,
+                                            depth + 1, maxParallelDepth, pool);
             }
             if (hasRight) {
-                rightChild = buildFromSorted(items, m, end, mid + 1, R);
+                rightChild = buildFromSorted(items, m, end, mid + 1, R,
+                                             depth + 1, maxParallelDepth, pool);
             }
         }
 
@@ -390,6 +662,77 @@ private:
             return findByPriority(node->right, mid + 1, R, p, rank);
         }
     }
+
+public:
+    // **CURSOR**
+    // Sequential access by rank.  cursor(k) walks root-to-leaf once and keeps
+    // the path; next() then moves to rank k+1 (the next smaller priority) by
+    // backtracking along that path, amortized O(1) per step.
+    // Invalidated by any update of the structure.
+    class RankCursor {
+    public:
+        bool valid() const { return depth > 0; }
+        int rank() const { return r; }
+        const T& value() const { return path[depth - 1]->value; }
+
+        // advance to rank() + 1; the cursor becomes invalid past the last element
+        void next() {
+            ++r;
+            while (depth > 1) {
+                const Node* child  = path[depth - 1];
+                const Node* parent = path[depth - 2];
+                --depth;
+                // came up from the right: left sibling holds the next ranks
+                if (child == parent->right && parent->left) {
+                    path[depth++] = parent->left;
+                    descendRightmost();
+                    return;
+                }
+            }
+            depth = 0;
+        }
+
+    private:
+        friend class PriorityStructure;
+
+        // root-to-leaf path; depth is ceil(log2(maxP)) + 1 <= 33 for int priorities
+        std::array<const Node*, 64> path{};
+        int depth = 0;
+        int r = 0;
+
+        // extend the path to the largest-priority leaf below its last node
+        void descendRightmost() {
+            const Node* node = path[depth - 1];
+            while (node->left || node->right) {
+                node = (node->right ? node->right : node->left);
+                path[depth++] = node;
+            }
+        }
+    };
+
+    // cursor positioned at the element with k-th largest priority
+    RankCursor cursor(int k) const {
+        int n = size();
+        if (k < 1 || k > n) {
+            throw std::out_of_range("cursor: k out of range");
+        }
+
+        RankCursor c;
+        c.r = k;
+        const Node* node = root;
+        c.path[c.depth++] = node;
+        while (node->left || node->right) {
+            int rightCount = (node->right ? node->right->cnt : 0);
+            if (rightCount >= k) {
+                node = node->right;
+            } else {
+                k -= rightCount;
+                node = node->left;
+            }
+            c.path[c.depth++] = node;
+        }
+        return c;
+    }
 };
 
 
@@ -397,6 +740,7 @@ private:
 
 
 
+#ifndef NO_DEMO_MAIN
 int main() {
     int maxP = 1000;
     PriorityStructure<int> ps(maxP);
@@ -444,5 +788,12 @@ int main() {
                   << ", rank=" << rank << "\n";
     }
 
+    // Walk ranks 5.. with a cursor
+    std::cout << "\nCursor from rank 5:\n";
+    for (auto c = ps.cursor(5); c.valid(); c.next()) {
+        std::cout << "  k=" << c.rank() << " -> value=" << c.value() << "\n";
+    }
+
     return 0;
 }
+#endif
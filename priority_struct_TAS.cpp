@@ -1,52 +1,124 @@
 #include <vector>
-#include <functional>
 #include <stdexcept>
 #include <iostream>
 #include <string>
 #include <algorithm>
+#include <memory>
+#include <array>
+#include <atomic>
+#include <utility>
+#include <limits>
+#include <type_traits>
+#include <cstdint>
 #include <omp.h>
+#include "perf_counters.h"
 
 
 // thread aligned subtrees
 
+
+// Optional per-node summary used by nextWithAggregate to skip whole subtrees.
+// An aggregate is a monoid over values:
+//     using type = ...;
+//     static type identity();
+//     static type of(const T& value);                  // summary of one leaf
+//     static type combine(const type& a, const type& b); // a: smaller ranks
+// NoAggregate stores nothing (empty base) and disables the pruned search.
+struct NoAggregate {};
+
+template <typename T>
+struct MinAggregate {
+    using type = T;
+    static type identity() { return std::numeric_limits<T>::max(); }
+    static type of(const T& value) { return value; }
+    static type combine(const type& a, const type& b) { return std::min(a, b); }
+};
+
 template <typename T>
+struct MaxAggregate {
+    using type = T;
+    static type identity() { return std::numeric_limits<T>::lowest(); }
+    static type of(const T& value) { return value; }
+    static type combine(const type& a, const type& b) { return std::max(a, b); }
+};
+
+template <typename Aggregate>
+struct AggregateField {
+    typename Aggregate::type agg = Aggregate::identity();
+};
+
+template <>
+struct AggregateField<NoAggregate> {};
+
+
+template <typename T, typename Aggregate = NoAggregate>
 class PriorityStructure {
+    static constexpr bool HAS_AGGREGATE = !std::is_same_v<Aggregate, NoAggregate>;
+
 public:
     explicit PriorityStructure(int maxPriority)
-        : maxP(maxPriority), root(nullptr) {}
+        : PriorityStructure(maxPriority, flatThreshold()) {}
+
+    // flatMax overrides flatThreshold() for this structure
+    PriorityStructure(int maxPriority, int flatMax)
+        : maxP(maxPriority), root(nullptr), flatLimit(std::max(flatMax, 0)) {}
+
+    // nodes belong to the arena, so a structure can be moved but not copied
+    PriorityStructure(const PriorityStructure&) = delete;
+    PriorityStructure& operator=(const PriorityStructure&) = delete;
+
+    PriorityStructure(PriorityStructure&& other) noexcept
+        : maxP(other.maxP), root(other.root), arena(std::move(other.arena)),
+          flatLimit(other.flatLimit), flat(std::move(other.flat)) {
+        other.root = nullptr;
+        other.flat.clear();
+    }
+
+    PriorityStructure& operator=(PriorityStructure&& other) noexcept {
+        if (this != &other) {
+            maxP  = other.maxP;
+            root  = other.root;
+            arena = std::move(other.arena);
+            flatLimit = other.flatLimit;
+            flat  = std::move(other.flat);
+            other.root = nullptr;
+            other.flat.clear();
+        }
+        return *this;
+    }
+
+    // the arena releases every node in one shot
+    ~PriorityStructure() = default;
 
     // **API FUNCTION**
     // INITIALIZE({(v1, p1), ..., (vl, pl)})
-    // initialize segment tree from list of (value, priority) pairs
-    void initialize(const std::vector<std::pair<T,int>>& elems) {
-        // TODO: in case we ever call initialize multiple times, need to delete original tree
-        root = nullptr;
-
-        if (elems.empty()) {
+    // initialize segment tree from list of (value, priority) pairs.
+    // With sortedByPriority the input must already be in increasing priority
+    // order and is used in place (no copy, no sort).
+    void initialize(const std::vector<std::pair<T,int>>& elems, bool sortedByPriority = false) {
+        if (sortedByPriority) {
+            build(elems.data(), static_cast<int>(elems.size()));
             return;
         }
 
         // sort elems as items
         std::vector<std::pair<T,int>> items = elems;
-        std::sort(items.begin(), items.end(),
-                  [](const auto& a, const auto& b) {
-                      return a.second < b.second;  // sort by priority
-                  });
+        sortByPriority(items);
+        build(items.data(), static_cast<int>(items.size()));
+    }
 
-        int numThreads = omp_get_max_threads();
-        int maxParallelDepth = 0;
-        while ((1 << maxParallelDepth) < numThreads) {
-            ++maxParallelDepth;
-        }
-        
+    // same, from items[0..count) already sorted by priority (used in place)
+    void initializeSorted(const std::pair<T,int>* items, int count) {
+        build(items, count);
+    }
 
-        #pragma omp parallel
-        {
-            #pragma omp single
-            {
-                root = buildFromSorted(items, 0, 1, maxP, 0, maxParallelDepth);
-            }
+    // same, but takes ownership of elems and sorts them in place
+    void initialize(std::vector<std::pair<T,int>>&& elems, bool sortedByPriority = false) {
+        std::vector<std::pair<T,int>> items = std::move(elems);
+        if (!sortedByPriority) {
+            sortByPriority(items);
         }
+        build(items.data(), static_cast<int>(items.size()));
     }
 
     // number of elements currently stored
@@ -54,10 +126,15 @@ public:
         if (root) {
             return root->cnt;
         } else {
-            return 0;
+            return static_cast<int>(flat.size());
         }
     }
 
+    // true if the elements are held as a flat sorted array (see flatThreshold())
+    bool isFlat() const {
+        return !flat.empty();
+    }
+
     // **API FUNCTION**
     // QUERY(k)
     // return the element with k-th largest priority
@@ -66,6 +143,10 @@ public:
         if (k < 1 || k > n) {
             throw std::out_of_range("QUERY: k out of range");
         }
+        PerfCounters::add(Counter::QueryCalls);
+        if (isFlat()) {
+            return flat[k - 1].first;
+        }
         return queryByRank(root, 1, maxP, k);
     }
 
@@ -78,6 +159,10 @@ public:
             throw std::out_of_range("updateValue: k out of range");
         }
 
+        if (isFlat()) {
+            flat[k - 1].first = v;
+            return;
+        }
         updateValueHelper(root, 1, maxP, k, v);
         return;
     }
@@ -91,6 +176,14 @@ public:
             throw std::out_of_range("find: priority out of range");
         }
         int rank = 0;
+        PerfCounters::add(Counter::FindCalls);
+        if (isFlat()) {
+            int j = flatPosition(p);
+            if (j == size() || flat[j].second != p) {
+                throw std::logic_error("findByPriority: priority not present");
+            }
+            return {flat[j].first, j + 1};
+        }
         return findByPriority(root, 1, maxP, p, rank);
     }
 
@@ -105,6 +198,24 @@ public:
         if (newP < 1 || newP > maxP) {
             throw std::out_of_range("updatePriority: newP out of range");
         }
+
+        if (isFlat()) {
+            int j = flatPosition(newP);
+            if (j < n && flat[j].second == newP) {
+                throw std::logic_error("updatePriority: new priority already present");
+            }
+            // slide the elements between the old and the new position by one
+            std::pair<T,int> item(std::move(flat[k - 1].first), newP);
+            if (j > k - 1) {
+                std::move(flat.begin() + k, flat.begin() + j, flat.begin() + k - 1);
+                flat[j - 1] = std::move(item);
+            } else {
+                std::move_backward(flat.begin() + j, flat.begin() + k - 1, flat.begin() + k);
+                flat[j] = std::move(item);
+            }
+            return;
+        }
+
         if (presentPriority(root, 1, maxP, newP)) {
             throw std::logic_error("updatePriority: new priority already present");
         }
@@ -115,11 +226,144 @@ public:
         return;
     }
 
+    // **BATCHED API**
+    // All ranks in a batch refer to the structure as it was before the batch.
+    // The batch is sorted once and split at every node across the rank boundary
+    // (like buildFromSorted splits items at mid), so k operations cost
+    // O(k log(maxP/k)) work; subtrees are handed to tasks (see nextWithRange).
+
+    // QUERY(k) for every k in ranks, results in input order
+    std::vector<T> batchQuery(const std::vector<int>& ranks) const {
+        std::vector<std::pair<int,int>> order = sortedRanks(ranks, "batchQuery");
+        std::vector<T> out(ranks.size());
+        if (isFlat()) {
+            for (size_t i = 0; i < ranks.size(); ++i) {
+                out[i] = flat[ranks[i] - 1].first;
+            }
+            return out;
+        }
+
+        auto leaf = [&](Node* node, int, const std::pair<int,int>* b, int cnt) {
+            for (int i = 0; i < cnt; ++i) {
+                out[b[i].second] = node->value;
+            }
+        };
+        runTasks(order.size(), [&](int maxParallelDepth) {
+            visitRanks(root, 1, maxP, order.data(), static_cast<int>(order.size()), 0,
+                       0, maxParallelDepth, leaf, false);
+        });
+        return out;
+    }
+
+    // UPDATEVALUE(ranks[i], values[i]) for every i; for a repeated rank the last value wins
+    void batchUpdateValue(const std::vector<int>& ranks, const std::vector<T>& values) {
+        if (ranks.size() != values.size()) {
+            throw std::invalid_argument("batchUpdateValue: ranks and values differ in size");
+        }
+        std::vector<std::pair<int,int>> order = sortedRanks(ranks, "batchUpdateValue");
+        if (isFlat()) {
+            for (size_t i = 0; i < ranks.size(); ++i) {
+                flat[ranks[i] - 1].first = values[i];
+            }
+            return;
+        }
+
+        auto leaf = [&](Node* node, int, const std::pair<int,int>* b, int cnt) {
+            node->value = values[b[cnt - 1].second];
+        };
+        runTasks(order.size(), [&](int maxParallelDepth) {
+            visitRanks(root, 1, maxP, order.data(), static_cast<int>(order.size()), 0,
+                       0, maxParallelDepth, leaf, true);
+        });
+    }
+
+    // UPDATEPRIORITY(k, p) for every (k, p) in updates.  Ranks must be distinct,
+    // new priorities distinct and not held by an element that stays in place.
+    void batchUpdatePriority(const std::vector<std::pair<int,int>>& updates) {
+        int k = static_cast<int>(updates.size());
+        if (k == 0) {
+            return;
+        }
+
+        std::vector<int> ranks(k);
+        for (int i = 0; i < k; ++i) {
+            ranks[i] = updates[i].first;
+            int p = updates[i].second;
+            if (p < 1 || p > maxP) {
+                throw std::out_of_range("batchUpdatePriority: newP out of range");
+            }
+        }
+        std::vector<std::pair<int,int>> order = sortedRanks(ranks, "batchUpdatePriority");
+        for (int i = 1; i < k; ++i) {
+            if (order[i].first == order[i - 1].first) {
+                throw std::logic_error("batchUpdatePriority: duplicate rank");
+            }
+        }
+        if (isFlat()) {
+            batchUpdatePriorityFlat(updates);
+            return;
+        }
+
+        // 1) read the moved elements: old priority and value, by input index
+        std::vector<int> oldP(k);
+        std::vector<T> moved(k);
+        auto leaf = [&](Node* node, int p, const std::pair<int,int>* b, int) {
+            oldP[b[0].second]  = p;
+            moved[b[0].second] = node->value;
+        };
+        runTasks(k, [&](int maxParallelDepth) {
+            visitRanks(root, 1, maxP, order.data(), k, 0, 0, maxParallelDepth, leaf, false);
+        });
+
+        // 2) new elements sorted by priority; a new priority may only collide
+        //    with an old priority that is being moved away in this batch
+        std::vector<std::pair<T,int>> items(k);
+        for (int i = 0; i < k; ++i) {
+            items[i] = {moved[i], updates[i].second};
+        }
+        std::sort(items.begin(), items.end(),
+                  [](const auto& a, const auto& b) { return a.second < b.second; });
+        for (int i = 1; i < k; ++i) {
+            if (items[i].second == items[i - 1].second) {
+                throw std::logic_error("batchUpdatePriority: duplicate new priority");
+            }
+        }
+        std::vector<int> leaving = oldP;
+        std::sort(leaving.begin(), leaving.end());
+
+        std::atomic<bool> collision(false);
+        runTasks(k, [&](int maxParallelDepth) {
+            #pragma omp taskloop grainsize(BATCH_THRESH) shared(collision) if(maxParallelDepth > 0)
+            for (int i = 0; i < k; ++i) {
+                int p = items[i].second;
+                if (presentPriority(root, 1, maxP, p) &&
+                    !std::binary_search(leaving.begin(), leaving.end(), p)) {
+                    collision.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+        if (collision.load()) {
+            throw std::logic_error("batchUpdatePriority: new priority already present");
+        }
+
+        // 3) erase all moved ranks in one pass, then insert all new priorities in one pass
+        std::vector<int> sortedR(k);
+        for (int i = 0; i < k; ++i) {
+            sortedR[i] = order[i].first;
+        }
+        runTasks(k, [&](int maxParallelDepth) {
+            root = eraseRanks(root, sortedR.data(), k, 0, 0, maxParallelDepth, arena);
+            insertSorted(root, 1, maxP, items.data(), k, 0, maxParallelDepth, arena);
+        });
+    }
+
     // **API FUNCTION**
     // NEXTWITH(k, f)
     // returns the smallest j >= k such that f(QUERY(j)) == true,
     // or size() + 1 if no such j exists.
-    int nextWith(int k, const std::function<bool(const T&)>& f) const {
+    // f is any callable bool(const T&), taken by type so that it inlines.
+    template <typename Pred>
+    int nextWith(int k, const Pred& f) const {
         int n = size();
         if (n == 0) {
             return 1; // l + 1 where l = 0
@@ -128,12 +372,45 @@ public:
         int p = k;
         if (p < 1) p = 1;
         if (p > n) return n + 1;
+        PerfCounters::add(Counter::NextWithCalls);
+        if (isFlat()) {
+            return scanFlat(p, n, f);
+        }
 
+        int cutoff = serialCutoff();
         int i = 0;
+
+        // Phases shorter than the cutoff: one cursor walks QUERY(p), QUERY(p+1), ...
+        // across the phase boundaries, amortized O(1) per rank and no OpenMP at all.
+        if (cutoff > 1) {
+            PerfCounters::add(Counter::PathSerial);
+            PerfCounters::add(Counter::NextWithProbes);
+            RankCursor c = cursor(p);
+
+            while (p <= n && (1 << i) < cutoff) {
+                int len = 1 << i;         // 2^i
+                int end = p + len - 1;
+                if (end > n) end = n;
+                PerfCounters::add(Counter::NextWithPhases);
+
+                // Phase i: scan QUERY(p), ..., QUERY(end)
+                for (; c.valid() && c.rank() <= end; c.next()) {
+                    PerfCounters::add(Counter::PredicateEvals);
+                    if (f(c.value())) {
+                        return c.rank();
+                    }
+                }
+
+                p += len; // advance start by 2^i
+                ++i;
+            }
+        }
+
         while (p <= n) {
             int len = 1 << i;         // 2^i
             int end = p + len - 1;
             if (end > n) end = n;
+            PerfCounters::add(Counter::NextWithPhases);
 
             // Parallel scan of QUERY(p..end)
             int best = nextWithRange(p, end, f);
@@ -149,47 +426,405 @@ public:
         return n + 1;
     }
 
-    
-    int nextWithRange(int L, int R, const std::function<bool(const T&)>& f) const {
+    // smallest j in [L, R] with f(QUERY(j)), or size() + 1.
+    // Ranges below serialCutoff() are scanned serially; larger ones as tasks,
+    // inside the caller's team if there is one, otherwise in a new team.
+    template <typename Pred>
+    int nextWithRange(int L, int R, const Pred& f) const {
         int n = size();
         if (n == 0) {
             return 1;
         }
 
+        // Clamp range
+        if (L < 1) L = 1;
+        if (R > n) R = n;
+        if (L > R) {
+            return n + 1;
+        }
+
+        if (isFlat()) {
+            return scanFlat(L, R, f);
+        }
+
+        long long len = static_cast<long long>(R) - L + 1;
+
+        if (len < serialCutoff() ||
+            (omp_in_parallel() ? omp_get_num_threads() : omp_get_max_threads()) == 1) {
+            PerfCounters::add(Counter::PathSerial);
+            return scanSerial(L, R, f);
+        }
+
+        if (omp_in_parallel()) {
+            PerfCounters::add(Counter::PathTasksInTeam);
+            return scanWithTasks(L, R, f);
+        }
+
+        PerfCounters::add(Counter::PathNewTeam);
         int best = n + 1;
+        #pragma omp parallel
+        {
+            #pragma omp single
+            {
+                best = scanWithTasks(L, R, f);
+            }
+        }
+        return best;
+    }
 
-        // Parallel loop over j in [L, R].
-        #pragma omp parallel for reduction(min:best)
-        for (int j = L; j <= R; ++j) {
-            T val = query(j);
-            if (f(val) && j < best) {
-                best = j;
+    // **API FUNCTION** (requires an Aggregate)
+    // NEXTWITH(k, f) with subtree pruning: canMatch(agg) must return false only if
+    // no value summarized by agg satisfies f.  Subtrees that cannot match are
+    // skipped, so an exact summary finds the answer in O(log maxP).
+    template <typename CanMatch, typename Pred>
+    int nextWithAggregate(int k, const CanMatch& canMatch, const Pred& f) const {
+        static_assert(HAS_AGGREGATE, "nextWithAggregate needs an Aggregate parameter");
+
+        int n = size();
+        if (k < 1) k = 1;
+        if (k > n) return n + 1;
+        PerfCounters::add(Counter::NextWithCalls);
+        if (isFlat()) {
+            return scanFlat(k, n, f);  // canMatch only prunes subtrees
+        }
+
+        int j = searchAggregate(root, 0, k, canMatch, f);
+        return (j < 0 ? n + 1 : j);
+    }
+
+    // summary of all stored values (identity if empty)
+    auto aggregate() const {
+        static_assert(HAS_AGGREGATE, "aggregate() needs an Aggregate parameter");
+        if (isFlat()) {
+            auto agg = Aggregate::identity();
+            for (const auto& item : flat) {
+                agg = Aggregate::combine(agg, Aggregate::of(item.first));
             }
+            return agg;
         }
+        return (root ? root->agg : Aggregate::identity());
+    }
 
-        return best;
+    // **EXECUTION POLICY**
+    // range length from which nextWith/nextWithRange go parallel (class-wide);
+    // the path each call takes is counted in Counter::Path* (PS_ENABLE_COUNTERS)
+    static int serialCutoff() {
+        return cutoffLen.load(std::memory_order_relaxed);
+    }
+
+    static void setSerialCutoff(int len) {
+        cutoffLen.store(std::max(len, 1), std::memory_order_relaxed);
+    }
+
+    // initialize with at most this many elements stores them as a flat array
+    // in rank order instead of a tree over [1, maxP]; 0 disables.  Class-wide
+    // default, read when a structure is constructed (the size of a structure
+    // only changes at initialize).
+    static int flatThreshold() {
+        return flatDefault.load(std::memory_order_relaxed);
+    }
+
+    static void setFlatThreshold(int count) {
+        flatDefault.store(std::max(count, 0), std::memory_order_relaxed);
     }
 
 
 private:
-    struct Node {
-        int cnt;           // number of elements in this interval
-        bool present;      // is there a value with this priority (meaningful for leaves)
-        T value;           // value at node (if present)
+    struct Node : AggregateField<Aggregate> {
+        int cnt;           // number of elements in this interval (a leaf is present iff cnt == 1)
+        T value;           // value at node (meaningful for leaves)
         Node* left;        // left child
         Node* right;       // right child
 
-        Node() : cnt(0), present(false), left(nullptr), right(nullptr) {}
+        Node() : cnt(0), left(nullptr), right(nullptr) {}
     };
 
+    // No separate compact Node for small trivially-copyable T.  With two child
+    // pointers the node is pointer-aligned, and a T of at most 4 bytes sits in
+    // the padding after cnt: storing values only at leaves, or packing cnt
+    // tighter, would free bytes that the alignment pads straight back.  A
+    // smaller node needs 32-bit child indices into the arena instead.
+    static_assert(HAS_AGGREGATE || sizeof(T) > 4 || !std::is_trivially_copyable_v<T> ||
+                  sizeof(Node) == 2 * sizeof(Node*) + 8,
+                  "small T must fit in the padding next to cnt");
+
+    // Slab allocator for Node.  Slabs grow geometrically and never move, and
+    // released nodes go on a free list threaded through `left`.  Not thread-safe:
+    // a parallel build task fills its own arena, which the parent absorbs after
+    // the taskwait.
+    class NodeArena {
+    public:
+        NodeArena() = default;
+        NodeArena(const NodeArena&) = delete;
+        NodeArena& operator=(const NodeArena&) = delete;
+
+        NodeArena(NodeArena&& other) noexcept {
+            *this = std::move(other);
+        }
+
+        NodeArena& operator=(NodeArena&& other) noexcept {
+            slabs    = std::move(other.slabs);
+            current  = std::exchange(other.current, nullptr);
+            used     = std::exchange(other.used, 0);
+            slabSize = std::exchange(other.slabSize, 0);
+            freeList = std::exchange(other.freeList, nullptr);
+            other.slabs.clear();
+            return *this;
+        }
+
+        // make sure the current slab has room for `count` more nodes
+        void reserve(int count) {
+            if (slabSize - used < count) {
+                addSlab(std::max(count, MIN_SLAB));
+            }
+        }
+
+        Node* alloc() {
+            PerfCounters::add(Counter::NodesAllocated);
+            if (freeList) {
+                Node* node = freeList;
+                freeList = node->left;
+                *node = Node();
+                return node;
+            }
+            if (used == slabSize) {
+                addSlab(std::min(std::max(2 * slabSize, MIN_SLAB), MAX_SLAB));
+            }
+            return &current[used++];
+        }
+
+        void release(Node* node) {
+            node->left = freeList;
+            freeList = node;
+        }
+
+        // take over every slab and free node of `other`
+        void absorb(NodeArena& other) {
+            for (auto& slab : other.slabs) {
+                slabs.push_back(std::move(slab));
+            }
+            // keep bumping from whichever slab has more room left
+            if (other.slabSize - other.used > slabSize - used) {
+                current  = other.current;
+                used     = other.used;
+                slabSize = other.slabSize;
+            }
+            while (other.freeList) {
+                Node* node = other.freeList;
+                other.freeList = node->left;
+                release(node);
+            }
+            other.slabs.clear();
+            other.current = nullptr;
+            other.used = other.slabSize = 0;
+        }
+
+        void clear() {
+            slabs.clear();
+            current = nullptr;
+            used = slabSize = 0;
+            freeList = nullptr;
+        }
+
+    private:
+        static constexpr int MIN_SLAB = 16;
+        static constexpr int MAX_SLAB = 1 << 16;
+
+        std::vector<std::unique_ptr<Node[]>> slabs;
+        Node* current  = nullptr;   // slab we bump-allocate from
+        int used       = 0;
+        int slabSize   = 0;
+        Node* freeList = nullptr;
+
+        void addSlab(int count) {
+            slabs.push_back(std::make_unique<Node[]>(count));
+            current  = slabs.back().get();
+            used     = 0;
+            slabSize = count;
+        }
+    };
+
+    // inputs below this size are sorted/checked serially
+    static constexpr int SORT_PARALLEL_THRESH = 1 << 16;
+    static constexpr int RADIX_BITS = 11;
+
+    // batches below this size are not split into tasks any further
+    static constexpr int BATCH_THRESH = 32;
+
+    static inline std::atomic<int> cutoffLen{2048};
+    static inline std::atomic<int> flatDefault{32};
+
+    // cursor walk of [L, R] on the calling thread
+    template <typename Pred>
+    int scanSerial(int L, int R, const Pred& f) const {
+        PerfCounters::add(Counter::NextWithProbes);
+        for (RankCursor c = cursor(L); c.valid() && c.rank() <= R; c.next()) {
+            PerfCounters::add(Counter::PredicateEvals);
+            if (f(c.value())) {
+                return c.rank();
+            }
+        }
+        return size() + 1;
+    }
+
+    // split [L, R] into chunks of at least serialCutoff() ranks, one task each;
+    // must be called from inside a parallel region
+    template <typename Pred>
+    int scanWithTasks(int L, int R, const Pred& f) const {
+        std::atomic<int> best(size() + 1);
+
+        long long len = static_cast<long long>(R) - L + 1;
+        long long byCutoff = (len + serialCutoff() - 1) / serialCutoff();
+        int chunks = static_cast<int>(std::min<long long>(4LL * omp_get_num_threads(), byCutoff));
+
+        #pragma omp taskgroup
+        {
+            for (int t = 0; t < chunks; ++t) {
+                int lo = L + static_cast<int>(len * t / chunks);
+                int hi = L + static_cast<int>(len * (t + 1) / chunks) - 1;
+
+                #pragma omp task firstprivate(lo, hi) shared(best, f)
+                {
+                    // chunks past an already found match have nothing to contribute
+                    PerfCounters::add(Counter::NextWithProbes);
+                    for (RankCursor c = cursor(lo);
+                         c.valid() && c.rank() <= hi &&
+                         c.rank() < best.load(std::memory_order_relaxed);
+                         c.next()) {
+                        PerfCounters::add(Counter::PredicateEvals);
+                        if (f(c.value())) {
+                            int cur = best.load(std::memory_order_relaxed);
+                            while (c.rank() < cur &&
+                                   !best.compare_exchange_weak(cur, c.rank(),
+                                                               std::memory_order_relaxed)) {
+                            }
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        return best.load(std::memory_order_relaxed);
+    }
+
     int maxP;           // max priority
     Node* root;         // root
+    NodeArena arena;    // owns every node of the tree
+    int flatLimit;      // initialize goes flat up to this many elements
+
+    // Flat mode (root == nullptr): the elements in rank order, i.e. by
+    // decreasing priority, for inputs of at most flatLimit elements.
+    // A few elements then cost a few words and a binary search instead of a
+    // root-to-leaf chain of ~log2(maxP) nodes each.
+    std::vector<std::pair<T,int>> flat;
+
+    // index of the first element of flat with priority <= p
+    int flatPosition(int p) const {
+        return static_cast<int>(std::lower_bound(flat.begin(), flat.end(), p,
+            [](const std::pair<T,int>& item, int q) { return item.second > q; }) - flat.begin());
+    }
+
+    // smallest j in [L, R] with f(flat[j - 1].first), or size() + 1
+    template <typename Pred>
+    int scanFlat(int L, int R, const Pred& f) const {
+        if (L < 1) L = 1;
+        if (R > size()) R = size();
+        for (int j = L; j <= R; ++j) {
+            PerfCounters::add(Counter::PredicateEvals);
+            if (f(flat[j - 1].first)) {
+                return j;
+            }
+        }
+        return size() + 1;
+    }
+
+    // batchUpdatePriority in flat mode; ranks were validated by the caller
+    void batchUpdatePriorityFlat(const std::vector<std::pair<int,int>>& updates) {
+        std::vector<char> moving(flat.size(), 0);
+        std::vector<std::pair<T,int>> items;
+        items.reserve(updates.size());
+        for (const auto& [k, p] : updates) {
+            moving[k - 1] = 1;
+            items.push_back({flat[k - 1].first, p});
+        }
+        std::sort(items.begin(), items.end(),
+                  [](const auto& a, const auto& b) { return a.second > b.second; });
+        for (size_t i = 1; i < items.size(); ++i) {
+            if (items[i].second == items[i - 1].second) {
+                throw std::logic_error("batchUpdatePriority: duplicate new priority");
+            }
+        }
+
+        // merge the elements that stay with the moved ones, both by decreasing priority
+        std::vector<std::pair<T,int>> merged;
+        merged.reserve(flat.size());
+        size_t i = 0;
+        for (size_t j = 0; j < flat.size(); ++j) {
+            if (moving[j]) {
+                continue;
+            }
+            while (i < items.size() && items[i].second > flat[j].second) {
+                merged.push_back(items[i++]);
+            }
+            if (i < items.size() && items[i].second == flat[j].second) {
+                throw std::logic_error("batchUpdatePriority: new priority already present");
+            }
+            merged.push_back(flat[j]);
+        }
+        merged.insert(merged.end(), items.begin() + i, items.end());
+        flat.swap(merged);
+    }
+
+    // rough node count for a tree over [L, R] holding `count` elements:
+    // ~2 * count for the branching part plus one chain of depth log2(R - L + 1)
+    static int nodeHint(int count, int L, int R) {
+        int depth = 1;
+        while ((1LL << (depth - 1)) < static_cast<long long>(R) - L + 1) {
+            ++depth;
+        }
+        return 2 * count + depth;
+    }
 
     // create node if null
-    static void ensureNode(Node*& node) {
+    void ensureNode(Node*& node) {
         if (!node) {
-            node = new Node();
+            node = arena.alloc();
+        }
+    }
+
+    // recompute node's aggregate from its value (leaf) or its children
+    static void pull(Node* node, bool leaf) {
+        if constexpr (HAS_AGGREGATE) {
+            if (leaf) {
+                node->agg = Aggregate::of(node->value);
+            } else {
+                node->agg = Aggregate::combine(
+                    node->right ? node->right->agg : Aggregate::identity(),  // smaller ranks
+                    node->left  ? node->left->agg  : Aggregate::identity());
+            }
+        }
+    }
+
+    // smallest rank >= k below node matching f, or -1;
+    // offset = number of elements ranked before this subtree
+    template <typename CanMatch, typename Pred>
+    int searchAggregate(const Node* node, int offset, int k,
+                        const CanMatch& canMatch, const Pred& f) const {
+        if (!node || offset + node->cnt < k || !canMatch(node->agg)) {
+            return -1;
+        }
+        if (!node->left && !node->right) {
+            PerfCounters::add(Counter::PredicateEvals);
+            return f(node->value) ? offset + 1 : -1;  // leaf
+        }
+
+        int rightCount = (node->right ? node->right->cnt : 0);
+        int j = searchAggregate(node->right, offset, k, canMatch, f);
+        if (j >= 0) {
+            return j;
         }
+        return searchAggregate(node->left, offset + rightCount, k, canMatch, f);
     }
 
     // insert (v, p)
@@ -200,8 +835,8 @@ private:
 
         // base case -- reached leaf
         if (L == R) {
-            node->present = true;
             node->value = v;
+            pull(node, true);
             return;
         }
 
@@ -212,30 +847,48 @@ private:
         } else {
             insert(node->right, mid+1, R, p, v);
         }
+        pull(node, false);
     }
 
     // erase element at kth priority (k-th largest), and return its value
     // recurse over nodes "node" which span interval ["L", "R"]
     T erase(Node*& node, int L, int R, int k) {
 
-        node->cnt -= 1; // TODO: if we ever reach a node with count 0, we can delete the whole thing to save memory
-                        // Pass down pointer to the node where cnt switched from >1 to =1
+        node->cnt -= 1;
 
-        // base case -- reached leaf
-        if (L == R) {
-            node->present = false;
-            return node->value;
+        // Last element below this node: the subtree is a single root-to-leaf
+        // chain, so take the value and hand the whole chain back to the arena.
+        // (This also covers the leaf itself.)
+        if (node->cnt == 0) {
+            T v = releaseChain(node);
+            node = nullptr;
+            return v;
         }
 
         int mid = (L + R) / 2;
         int rightCount = (node->right ? node->right->cnt : 0);
+        T v;
         if (rightCount >= k) {
             // k-th largest is in right subtree
-            return erase(node->right, mid + 1, R, k);
+            v = erase(node->right, mid + 1, R, k);
         } else {
             // k-th largest is in left subtree
-            return erase(node->left, L, mid, k - rightCount);
+            v = erase(node->left, L, mid, k - rightCount);
+        }
+        pull(node, false);
+        return v;
+    }
+
+    // release a subtree holding exactly one element, return that element's value
+    T releaseChain(Node* node) {
+        while (node->left || node->right) {
+            Node* next = (node->left ? node->left : node->right);
+            arena.release(node);
+            node = next;
         }
+        T v = node->value;
+        arena.release(node);
+        return v;
     }
 
     // is there an element with priority p?
@@ -244,7 +897,7 @@ private:
 
         // base cases
         if (!node) return false;
-        if (L == R) return node->present;
+        if (L == R) return node->cnt != 0;
 
         // recursive step
         int mid = (L + R) / 2;
@@ -259,24 +912,143 @@ private:
     }
 
 
+    // build from items[0..m), sorted by priority; replaces the current tree
+    void build(const std::pair<T,int>* items, int m) {
+        if (m > 0) {
+            checkSorted(items, m);
+        }
+
+        // drop any previous tree in one shot
+        arena.clear();
+        root = nullptr;
+        flat.clear();
+
+        if (m == 0) {
+            return;
+        }
+
+        if (m <= flatLimit) {
+            // items are increasing in priority, flat is in rank order
+            flat.assign(std::make_reverse_iterator(items + m), std::make_reverse_iterator(items));
+            return;
+        }
+
+        arena.reserve(nodeHint(m, 1, maxP));
+
+        // small inputs are built serially; large ones as tasks, in the caller's
+        // team when initialize runs inside a parallel region
+        runTasks(m, [&](int maxParallelDepth) {
+            root = buildFromSorted(items, 0, m, 1, maxP, 0, maxParallelDepth, arena);
+        });
+    }
+
+    // Priorities in sorted input are bounded iff the two ends are, and unique iff
+    // neighbours differ, so this single pass replaces per-element presence checks.
+    void checkSorted(const std::pair<T,int>* items, int m) const {
+        if (items[0].second < 1 || items[m - 1].second > maxP) {
+            throw std::out_of_range("priority out of range in initialize");
+        }
+
+        int duplicate = 0;
+        int unsorted  = 0;
+        #pragma omp parallel for reduction(|:duplicate, unsorted) \
+                if(m >= SORT_PARALLEL_THRESH && !omp_in_parallel())
+        for (int i = 1; i < m; ++i) {
+            duplicate |= (items[i].second == items[i - 1].second);
+            unsorted  |= (items[i].second <  items[i - 1].second);
+        }
+
+        if (unsorted) {
+            throw std::logic_error("initialize: input not sorted by priority");
+        }
+        if (duplicate) {
+            throw std::logic_error("duplicate priority in initialize");
+        }
+    }
+
+    // sort by priority: comparison sort for small inputs, otherwise a parallel
+    // LSD radix sort over the bounded priorities [1, maxP]
+    void sortByPriority(std::vector<std::pair<T,int>>& items) const {
+        if (static_cast<int>(items.size()) < SORT_PARALLEL_THRESH ||
+            omp_in_parallel() || omp_get_max_threads() == 1) {
+            std::sort(items.begin(), items.end(),
+                      [](const auto& a, const auto& b) {
+                          return a.second < b.second;  // sort by priority
+                      });
+            return;
+        }
+        radixSortByPriority(items);
+    }
+
+    void radixSortByPriority(std::vector<std::pair<T,int>>& items) const {
+        const int m = static_cast<int>(items.size());
+        const int BUCKETS = 1 << RADIX_BITS;
+
+        int bits = 1;
+        while (bits < 31 && (1LL << bits) <= maxP) {
+            ++bits;
+        }
+
+        std::vector<std::pair<T,int>> buf(m);
+        std::vector<int> count(static_cast<std::size_t>(omp_get_max_threads()) * BUCKETS);
+
+        for (int shift = 0; shift < bits; shift += RADIX_BITS) {
+            // every thread histograms one contiguous block, offsets are laid out
+            // digit-major / thread-minor, so the scatter is stable
+            #pragma omp parallel
+            {
+                int t  = omp_get_thread_num();
+                int nt = omp_get_num_threads();
+                int lo = static_cast<int>(static_cast<long long>(m) * t / nt);
+                int hi = static_cast<int>(static_cast<long long>(m) * (t + 1) / nt);
+                int* c = &count[static_cast<std::size_t>(t) * BUCKETS];
+
+                std::fill(c, c + BUCKETS, 0);
+                for (int i = lo; i < hi; ++i) {
+                    ++c[(items[i].second >> shift) & (BUCKETS - 1)];
+                }
+
+                #pragma omp barrier
+                #pragma omp single
+                {
+                    int sum = 0;
+                    for (int d = 0; d < BUCKETS; ++d) {
+                        for (int u = 0; u < nt; ++u) {
+                            int& slot = count[static_cast<std::size_t>(u) * BUCKETS + d];
+                            int here = slot;
+                            slot = sum;
+                            sum += here;
+                        }
+                    }
+                }
+
+                for (int i = lo; i < hi; ++i) {
+                    buf[c[(items[i].second >> shift) & (BUCKETS - 1)]++] = std::move(items[i]);
+                }
+            }
+            items.swap(buf);
+        }
+    }
+
     // items: (value, priority) sorted by priority (.second)
-    Node* buildFromSorted(const std::vector<std::pair<T,int>>& items,
+    Node* buildFromSorted(const std::pair<T,int>* items,
                           int start, int end, // indices spanned by items
                           int L, int R,       // interval spanned by this node
                           int depth,
-                          int maxParallelDepth) {
+                          int maxParallelDepth,
+                          NodeArena& pool) {  // arena of the calling task
         
         if (start >= end) { // no elements
             return nullptr;
         }
 
-        Node* node = new Node();
+        Node* node = pool.alloc();
         node->cnt = end - start;  // number of elements in this subtree
 
         if (L == R) {
             // Leaf. All items[start..end) share priority L; under uniqueness, end-start == 1.
-            node->present = true;
             node->value   = items[start].first;  // value (since pair is (value, priority))
+            pull(node, true);
             return node;
         }
 
@@ -284,13 +1056,13 @@ private:
 
         // Split items[start..end) into left (priority <= mid) and right (> mid)
         auto it = std::lower_bound(
-            items.begin() + start, items.begin() + end,
+            items + start, items + end,
             mid + 1,
             [](const std::pair<T,int>& pr, int value) {
                 return pr.second < value;  // compare priority with mid+1
             }
         );
-        int m = static_cast<int>(it - items.begin()); // index of split
+        int m = static_cast<int>(it - items); // index of split
 
         Node* leftChild  = nullptr;
         Node* rightChild = nullptr;
@@ -307,38 +1079,224 @@ private:
 
         if (canParallelizeHere) {
             // Spawn ONE subtree as a task; current thread handles the other.
-            #pragma omp task shared(leftChild)
+            // The task allocates from its own arena, absorbed after the taskwait.
+            NodeArena taskPool;
+            #pragma omp task shared(leftChild, taskPool)
             {
+                taskPool.reserve(nodeHint(m - start, L, mid));
                 leftChild = buildFromSorted(items, start, m, L, mid,
-                                            depth + 1, maxParallelDepth);
+                                            depth + 1, maxParallelDepth, taskPool);
             }
             rightChild = buildFromSorted(items, m, end, mid + 1, R,
-                                         depth + 1, maxParallelDepth);
+                                         depth + 1, maxParallelDepth, pool);
             #pragma omp taskwait
+            pool.absorb(taskPool);
         } else {
             // recurse linearly (no new tasks)
             if (hasLeft) {
                 leftChild = buildFromSorted(items, start, m, L, mid,
-                                            depth + 1, maxParallelDepth);
+                                            depth + 1, maxParallelDepth, pool);
             }
             if (hasRight) {
                 rightChild = buildFromSorted(items, m, end, mid + 1, R,
-                                             depth + 1, maxParallelDepth);
+                                             depth + 1, maxParallelDepth, pool);
             }
         }
 
         node->left  = leftChild;
         node->right = rightChild;
+        pull(node, false);
+        return node;
+    }
+
+
+
+    // ------------------------------------------------------------------
+    // batched traversal helpers
+
+    // (rank, input index) sorted by rank, range-checked against size()
+    std::vector<std::pair<int,int>> sortedRanks(const std::vector<int>& ranks,
+                                                const char* who) const {
+        int n = size();
+        std::vector<std::pair<int,int>> order(ranks.size());
+        for (size_t i = 0; i < ranks.size(); ++i) {
+            if (ranks[i] < 1 || ranks[i] > n) {
+                throw std::out_of_range(std::string(who) + ": k out of range");
+            }
+            order[i] = {ranks[i], static_cast<int>(i)};
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        return order;
+    }
+
+    static int parallelDepthFor(int numThreads) {
+        int depth = 0;
+        while ((1 << depth) < numThreads) {
+            ++depth;
+        }
+        return depth;
+    }
+
+    // run body(maxParallelDepth): serially (depth 0) for small batches, otherwise
+    // with tasks in the enclosing team, or in a new team if there is none
+    template <typename Body>
+    void runTasks(std::size_t work, const Body& body) const {
+        int team = omp_in_parallel() ? omp_get_num_threads() : omp_get_max_threads();
+        if (static_cast<long long>(work) < serialCutoff() || team == 1) {
+            body(0);
+            return;
+        }
+        int maxParallelDepth = parallelDepthFor(team);
+        if (omp_in_parallel()) {
+            body(maxParallelDepth);
+            return;
+        }
+        #pragma omp parallel
+        {
+            #pragma omp single
+            {
+                body(maxParallelDepth);
+            }
+        }
+    }
+
+    // Visit the leaves of the sorted ranks b[0..cnt) (relative to offset = number of
+    // elements ranked before this subtree).  leaf(node, priority, b, cnt) gets every
+    // batch entry that landed on that leaf; pullUp refreshes aggregates on the way up.
+    template <typename LeafFn>
+    static void visitRanks(Node* node, int L, int R,
+                           const std::pair<int,int>* b, int cnt, int offset,
+                           int depth, int maxParallelDepth,
+                           const LeafFn& leaf, bool pullUp) {
+        if (cnt == 0) {
+            return;
+        }
+        if (L == R) {
+            leaf(node, L, b, cnt);
+            if (pullUp) pull(node, true);
+            return;
+        }
+
+        int mid = (L + R) / 2;
+        int rightCount = (node->right ? node->right->cnt : 0);
+
+        // b[0..m) falls into the right subtree (smaller ranks), b[m..cnt) into the left
+        int m = static_cast<int>(std::lower_bound(
+            b, b + cnt, offset + rightCount + 1,
+            [](const std::pair<int,int>& e, int r) { return e.first < r; }) - b);
+
+        if (depth < maxParallelDepth && cnt >= BATCH_THRESH && 0 < m && m < cnt) {
+            #pragma omp task
+            visitRanks(node->left, L, mid, b + m, cnt - m, offset + rightCount,
+                       depth + 1, maxParallelDepth, leaf, pullUp);
+            visitRanks(node->right, mid + 1, R, b, m, offset,
+                       depth + 1, maxParallelDepth, leaf, pullUp);
+            #pragma omp taskwait
+        } else {
+            visitRanks(node->right, mid + 1, R, b, m, offset,
+                       depth + 1, maxParallelDepth, leaf, pullUp);
+            visitRanks(node->left, L, mid, b + m, cnt - m, offset + rightCount,
+                       depth + 1, maxParallelDepth, leaf, pullUp);
+        }
+        if (pullUp) pull(node, false);
+    }
+
+    // Erase the sorted, distinct ranks r[0..cnt) below node (offset as above).
+    // A subtree losing all of its elements is released in one piece.
+    // Returns the new subtree root (nullptr if emptied).
+    Node* eraseRanks(Node* node, const int* r, int cnt, int offset,
+                     int depth, int maxParallelDepth, NodeArena& pool) {
+        if (cnt == 0) {
+            return node;
+        }
+        if (cnt == node->cnt) {
+            releaseSubtree(node, pool);
+            return nullptr;
+        }
+
+        node->cnt -= cnt;
+        int rightCount = (node->right ? node->right->cnt : 0);
+        int m = static_cast<int>(std::lower_bound(r, r + cnt, offset + rightCount + 1) - r);
+
+        if (depth < maxParallelDepth && cnt >= BATCH_THRESH && 0 < m && m < cnt) {
+            NodeArena taskPool;
+            Node* leftChild = node->left;
+            #pragma omp task shared(leftChild, taskPool)
+            leftChild = eraseRanks(leftChild, r + m, cnt - m, offset + rightCount,
+                                   depth + 1, maxParallelDepth, taskPool);
+            node->right = eraseRanks(node->right, r, m, offset,
+                                     depth + 1, maxParallelDepth, pool);
+            #pragma omp taskwait
+            node->left = leftChild;
+            pool.absorb(taskPool);
+        } else {
+            node->right = eraseRanks(node->right, r, m, offset,
+                                     depth + 1, maxParallelDepth, pool);
+            node->left  = eraseRanks(node->left, r + m, cnt - m, offset + rightCount,
+                                     depth + 1, maxParallelDepth, pool);
+        }
+        pull(node, false);
         return node;
     }
 
+    // Insert items[0..cnt), sorted by priority and absent from the tree.
+    void insertSorted(Node*& node, int L, int R,
+                      const std::pair<T,int>* items, int cnt,
+                      int depth, int maxParallelDepth, NodeArena& pool) {
+        if (cnt == 0) {
+            return;
+        }
+        if (!node) {
+            node = pool.alloc();
+        }
+        node->cnt += cnt;
 
+        if (L == R) {
+            node->value   = items[0].first;
+            pull(node, true);
+            return;
+        }
+
+        int mid = (L + R) / 2;
+        int m = static_cast<int>(std::lower_bound(
+            items, items + cnt, mid + 1,
+            [](const std::pair<T,int>& pr, int value) { return pr.second < value; }) - items);
+
+        if (depth < maxParallelDepth && cnt >= BATCH_THRESH && 0 < m && m < cnt) {
+            NodeArena taskPool;
+            #pragma omp task shared(node, taskPool)
+            insertSorted(node->left, L, mid, items, m, depth + 1, maxParallelDepth, taskPool);
+            insertSorted(node->right, mid + 1, R, items + m, cnt - m,
+                         depth + 1, maxParallelDepth, pool);
+            #pragma omp taskwait
+            pool.absorb(taskPool);
+        } else {
+            insertSorted(node->left, L, mid, items, m, depth + 1, maxParallelDepth, pool);
+            insertSorted(node->right, mid + 1, R, items + m, cnt - m,
+                         depth + 1, maxParallelDepth, pool);
+        }
+        pull(node, false);
+    }
+
+    // hand every node of a subtree back to pool
+    static void releaseSubtree(Node* node, NodeArena& pool) {
+        std::vector<Node*> stack{node};
+        while (!stack.empty()) {
+            Node* cur = stack.back();
+            stack.pop_back();
+            if (cur->left)  stack.push_back(cur->left);
+            if (cur->right) stack.push_back(cur->right);
+            pool.release(cur);
+        }
+    }
 
     // return the value with k-th largest priority
     T queryByRank(Node* node, int L, int R, int k) const {
         if (!node || k < 1 || k > node->cnt) {
             throw std::logic_error("queryByRank: inconsistent tree");
         }
+        PerfCounters::add(Counter::QueryDepth);
 
         if (L == R) {
             // leaf
@@ -364,6 +1322,7 @@ private:
         if (L == R) {
             // leaf
             node->value = v;
+            pull(node, true);
             return;
         }
         int mid = (L + R) / 2;
@@ -371,12 +1330,11 @@ private:
         if (rightCount >= k) {
             // k-th largest is in right subtree
             updateValueHelper(node->right, mid+1, R, k, v);
-            return;
         } else {
             // k-th largest is in left subtree
             updateValueHelper(node->left, L, mid, k - rightCount, v);
-            return;
         }
+        pull(node, false);
     }
 
     // helper for FIND(p)
@@ -388,9 +1346,10 @@ private:
 
             throw std::logic_error("findByPriority: priority not present");
         }
+        PerfCounters::add(Counter::FindDepth);
 
         if (L == R) {
-            if (node->cnt == 0 || !node->present) {
+            if (node->cnt == 0) {
                 // ERROR
                 throw std::logic_error("findByPriority: priority not present at leaf");
             }
@@ -407,8 +1366,92 @@ private:
             return findByPriority(node->right, mid + 1, R, p, rank);
         }
     }
+
+public:
+    // **CURSOR**
+    // Sequential access by rank.  cursor(k) walks root-to-leaf once and keeps
+    // the path; next() then moves to rank k+1 (the next smaller priority) by
+    // backtracking along that path, amortized O(1) per step.
+    // Invalidated by any update of the structure.
+    class RankCursor {
+    public:
+        bool valid() const { return items ? r <= count : depth > 0; }
+        int rank() const { return r; }
+        const T& value() const { return items ? items[r - 1].first : path[depth - 1]->value; }
+
+        // advance to rank() + 1; the cursor becomes invalid past the last element
+        void next() {
+            ++r;
+            if (items) {
+                return;
+            }
+            while (depth > 1) {
+                const Node* child  = path[depth - 1];
+                const Node* parent = path[depth - 2];
+                --depth;
+                // came up from the right: left sibling holds the next ranks
+                if (child == parent->right && parent->left) {
+                    path[depth++] = parent->left;
+                    descendRightmost();
+                    return;
+                }
+            }
+            depth = 0;
+        }
+
+    private:
+        friend class PriorityStructure;
+
+        // root-to-leaf path; depth is ceil(log2(maxP)) + 1 <= 33 for int priorities
+        std::array<const Node*, 64> path{};
+        int depth = 0;
+        int r = 0;
+
+        // flat mode: the rank-ordered array instead of a path
+        const std::pair<T,int>* items = nullptr;
+        int count = 0;
+
+        // extend the path to the largest-priority leaf below its last node
+        void descendRightmost() {
+            const Node* node = path[depth - 1];
+            while (node->left || node->right) {
+                node = (node->right ? node->right : node->left);
+                path[depth++] = node;
+            }
+        }
+    };
+
+    // cursor positioned at the element with k-th largest priority
+    RankCursor cursor(int k) const {
+        int n = size();
+        if (k < 1 || k > n) {
+            throw std::out_of_range("cursor: k out of range");
+        }
+
+        RankCursor c;
+        c.r = k;
+        if (isFlat()) {
+            c.items = flat.data();
+            c.count = n;
+            return c;
+        }
+        const Node* node = root;
+        c.path[c.depth++] = node;
+        while (node->left || node->right) {
+            int rightCount = (node->right ? node->right->cnt : 0);
+            if (rightCount >= k) {
+                node = node->right;
+            } else {
+                k -= rightCount;
+                node = node->left;
+            }
+            c.path[c.depth++] = node;
+        }
+        return c;
+    }
 };
 
+#ifndef NO_DEMO_MAIN
 int main() {
     int maxP = 1000;
     PriorityStructure<int> ps(maxP);
@@ -456,5 +1499,26 @@ int main() {
                   << ", rank=" << rank << "\n";
     }
 
+    // Same elements with a per-node minimum: jump straight to values < 600
+    PriorityStructure<int, MinAggregate<int>> psMin(maxP);
+    psMin.initialize(elems);
+    psMin.updateValue(2, 150);  // rank 2 (value 800) -> 150
+    std::cout << "\nMin value: " << psMin.aggregate() << "\n";
+    std::cout << "Ranks with value < 600 (pruned search):";
+    auto below600 = [](const int& v) { return v < 600; };
+    auto mayHaveBelow600 = [](const int& minValue) { return minValue < 600; };
+    for (int k = psMin.nextWithAggregate(1, mayHaveBelow600, below600); k <= n;
+         k = psMin.nextWithAggregate(k + 1, mayHaveBelow600, below600)) {
+        std::cout << " " << k;
+    }
+    std::cout << "\n";
+
+    // Walk ranks 5.. with a cursor
+    std::cout << "\nCursor from rank 5:\n";
+    for (auto c = ps.cursor(5); c.valid(); c.next()) {
+        std::cout << "  k=" << c.rank() << " -> value=" << c.value() << "\n";
+    }
+
     return 0;
 }
+#endif
@@ -0,0 +1,455 @@
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+#include <omp.h>
+#include "gather_kernel.h"
+
+
+// array-backed (implicit, pointer-free) layout
+//
+// Elements live in "slots" sorted by decreasing priority, so the k-th largest
+// priority is the k-th live slot from the left and values are dense in rank order.
+// Live-slot counts are kept in an implicit complete binary tree stored in
+// Eytzinger (BFS) order: node i has children 2i and 2i+1, the leaf of slot s is
+// node cap + s, and the root is node 1.  No pointers are chased on any path.
+
+template <typename T>
+class PriorityStructure {
+public:
+    explicit PriorityStructure(int maxPriority)
+        : maxP(maxPriority), cap(0), numSlots(0), dead(0) {}
+
+    // **API FUNCTION**
+    // INITIALIZE({(v1, p1), ..., (vl, pl)})
+    // initialize slot arrays from list of (value, priority) pairs
+    void initialize(const std::vector<std::pair<T,int>>& elems) {
+        prio.clear();
+        vals.clear();
+        cnt.clear();
+        cap = 0;
+        numSlots = 0;
+        dead = 0;
+
+        if (elems.empty()) {
+            return;
+        }
+
+        // sort elems as items, largest priority first (= rank order)
+        std::vector<std::pair<T,int>> items = elems;
+        std::sort(items.begin(), items.end(),
+                  [](const auto& a, const auto& b) {
+                      return a.second > b.second;
+                  });
+
+        // priorities must be bounded and unique; after sorting both are local checks
+        if (items.front().second > maxP || items.back().second < 1) {
+            throw std::out_of_range("priority out of range in initialize");
+        }
+        for (size_t i = 1; i < items.size(); ++i) {
+            if (items[i].second == items[i - 1].second) {
+                throw std::logic_error("duplicate priority in initialize");
+            }
+        }
+
+        numSlots = static_cast<int>(items.size());
+        prio.resize(numSlots);
+        vals.resize(numSlots);
+
+        #pragma omp parallel for if(numSlots >= PARALLEL_THRESH)
+        for (int s = 0; s < numSlots; ++s) {
+            vals[s] = items[s].first;
+            prio[s] = items[s].second;
+        }
+
+        buildCounts();
+    }
+
+    // number of elements currently stored
+    int size() const {
+        if (cnt.empty()) {
+            return 0;
+        } else {
+            return cnt[1];
+        }
+    }
+
+    // **API FUNCTION**
+    // QUERY(k)
+    // return the element with k-th largest priority
+    T query(int k) const {
+        int n = size();
+        if (k < 1 || k > n) {
+            throw std::out_of_range("QUERY: k out of range");
+        }
+        return vals[slotOfRank(k)];
+    }
+
+    // **API FUNCTION**
+    // UPDATEVALUE(k, v)
+    // update the value of the element with k-th largest priorit to v.
+    void updateValue(int k, const T& v) {
+        int n = size();
+        if (k < 1 || k > n) {
+            throw std::out_of_range("updateValue: k out of range");
+        }
+
+        vals[slotOfRank(k)] = v;
+        return;
+    }
+
+    // **API FUNCTION**
+    // FIND(p)
+    // return the rank (k) and value (v) of the element with priority p
+    std::pair<T,int> find(int p) const {
+        if (p < 1 || p > maxP) {
+            // ERROR
+            throw std::out_of_range("find: priority out of range");
+        }
+
+        int s = slotOfPriority(p);
+        if (s == numSlots || prio[s] != p || !liveSlot(s)) {
+            // ERROR
+            throw std::logic_error("find: priority not present");
+        }
+        return {vals[s], liveBefore(s) + 1};
+    }
+
+    // **API FUNCTION**
+    // UPDATEPRIORITY(k, p)
+    // change the priority of the element with k-th largest priority to p.
+    void updatePriority(int k, int newP) {
+        int n = size();
+        if (k < 1 || k > n) {
+            throw std::out_of_range("updatePriority: k out of range");
+        }
+        if (newP < 1 || newP > maxP) {
+            throw std::out_of_range("updatePriority: newP out of range");
+        }
+        int t = slotOfPriority(newP);
+        if (t < numSlots && prio[t] == newP && liveSlot(t)) {
+            throw std::logic_error("updatePriority: new priority already present");
+        }
+
+        // Kill old slot, then place new priority into a dead neighbour slot if
+        // the order allows it, otherwise compact and rebuild (O(l)).
+        int s = slotOfRank(k);
+        T v = vals[s];
+        setSlot(s, -1);
+        dead += 1;
+
+        placeNew(newP, v);
+        return;
+    }
+
+    // **API FUNCTION**
+    // NEXTWITH(k, f)
+    // returns the smallest j >= k such that f(QUERY(j)) == true,
+    // or size() + 1 if no such j exists.
+    int nextWith(int k, const std::function<bool(const T&)>& f) const {
+        int n = size();
+        if (n == 0) {
+            return 1; // l + 1 where l = 0
+        }
+
+        int j = k;
+        if (j < 1) j = 1;
+        if (j > n) return n + 1;
+
+        // Values are dense in rank order: locate rank k once, then stream the
+        // slots to the right (skipping dead ones) instead of one descent per rank.
+        for (int s = slotOfRank(j); s < numSlots; ++s) {
+            if (!liveSlot(s)) {
+                continue;
+            }
+            if (f(vals[s])) {
+                return j;
+            }
+            ++j;
+        }
+
+        return n + 1;
+    }
+
+    // NEXTWITH(k, f) for f(v) = (table[v] == target) with int values: values are
+    // dense in rank order, so the slots are tested in blocks by the gather kernel
+    // and matching dead slots are skipped.  table must be indexable by every
+    // value ever stored.
+    int nextWithGather(int k, const int* table, int target) const {
+        static_assert(std::is_same_v<T, int>, "nextWithGather needs int values");
+        int n = size();
+        if (n == 0) {
+            return 1;
+        }
+        if (k < 1) k = 1;
+        if (k > n) return n + 1;
+
+        for (int s = slotOfRank(k); s < numSlots; ++s) {
+            s += firstGatherMatch(vals.data() + s, numSlots - s, table, target);
+            if (s < numSlots && liveSlot(s)) {
+                return liveBefore(s) + 1;
+            }
+        }
+        return n + 1;
+    }
+
+
+    // smallest j in [L, R] with f(QUERY(j)), or size() + 1.
+    // Ranks map to a contiguous run of slots, so short ranges stream the live
+    // slots serially (as nextWith does); long ones split the slot run.
+    int nextWithRange(int L, int R, const std::function<bool(const T&)>& f) const {
+        int n = size();
+        if (n == 0) {
+            return 1;
+        }
+
+        // Clamp range
+        if (L < 1) L = 1;
+        if (R > n) R = n;
+        if (L > R) {
+            return n + 1;
+        }
+
+        int first = slotOfRank(L);
+        int last = slotOfRank(R);
+
+        if (last - first + 1 < PARALLEL_THRESH) {
+            int j = L;
+            for (int s = first; s <= last; ++s) {
+                if (!liveSlot(s)) {
+                    continue;
+                }
+                if (f(vals[s])) {
+                    return j;
+                }
+                ++j;
+            }
+            return n + 1;
+        }
+
+        int bestSlot = numSlots;
+        #pragma omp parallel for reduction(min:bestSlot) if(!omp_in_parallel())
+        for (int s = first; s <= last; ++s) {
+            if (s < bestSlot && liveSlot(s) && f(vals[s])) {
+                bestSlot = s;
+            }
+        }
+
+        if (bestSlot == numSlots) {
+            return n + 1;
+        }
+        return liveBefore(bestSlot) + 1;
+    }
+
+
+private:
+    // Threshold to avoid opening parallel regions for tiny arrays
+    static constexpr int PARALLEL_THRESH = 1 << 14;
+
+    int maxP;               // max priority
+    int cap;                // number of leaves (power of two >= numSlots)
+    int numSlots;           // slots in use, live or dead
+    int dead;               // dead slots (left behind by updatePriority)
+
+    std::vector<int> prio;  // prio[s]: priority of slot s, strictly decreasing
+    std::vector<T> vals;    // vals[s]: value of slot s
+    std::vector<int> cnt;   // Eytzinger-ordered live counts, size 2 * cap
+
+    bool liveSlot(int s) const {
+        return cnt[cap + s] != 0;
+    }
+
+    // build cnt bottom-up from the (all live) slots [0, numSlots)
+    void buildCounts() {
+        cap = 1;
+        while (cap < numSlots) {
+            cap <<= 1;
+        }
+        cnt.assign(2 * cap, 0);
+
+        for (int s = 0; s < numSlots; ++s) {
+            cnt[cap + s] = 1;
+        }
+        for (int lo = cap / 2; lo >= 1; lo /= 2) {
+            #pragma omp parallel for if(lo >= PARALLEL_THRESH)
+            for (int i = lo; i < 2 * lo; ++i) {
+                cnt[i] = cnt[2 * i] + cnt[2 * i + 1];
+            }
+        }
+    }
+
+    // add delta to leaf s and all of its ancestors
+    void setSlot(int s, int delta) {
+        for (int i = cap + s; i >= 1; i /= 2) {
+            cnt[i] += delta;
+        }
+    }
+
+    // slot holding the k-th live element
+    int slotOfRank(int k) const {
+        if (dead == 0) {
+            return k - 1;  // no holes: rank is a direct index
+        }
+
+        int i = 1;
+        while (i < cap) {
+            int leftCount = cnt[2 * i];
+            if (leftCount >= k) {
+                i = 2 * i;
+            } else {
+                k -= leftCount;
+                i = 2 * i + 1;
+            }
+        }
+        return i - cap;
+    }
+
+    // number of live slots strictly left of slot s
+    int liveBefore(int s) const {
+        if (dead == 0) {
+            return s;
+        }
+
+        int before = 0;
+        for (int i = cap + s; i > 1; i /= 2) {
+            if (i & 1) {
+                before += cnt[i - 1];  // left sibling precedes us
+            }
+        }
+        return before;
+    }
+
+    // first slot whose priority is <= p (numSlots if none)
+    int slotOfPriority(int p) const {
+        auto it = std::lower_bound(prio.begin(), prio.begin() + numSlots, p,
+                                   std::greater<int>());
+        return static_cast<int>(it - prio.begin());
+    }
+
+    // insert (v, p) where p is not a live priority
+    void placeNew(int p, const T& v) {
+        int pos = slotOfPriority(p);
+
+        // A dead slot at pos (prio <= p) or pos - 1 (prio > p) can take p without
+        // breaking the decreasing order of prio.
+        int reuse = -1;
+        if (pos < numSlots && !liveSlot(pos)) {
+            reuse = pos;
+        } else if (pos > 0 && !liveSlot(pos - 1)) {
+            reuse = pos - 1;
+        }
+
+        if (reuse >= 0) {
+            prio[reuse] = p;
+            vals[reuse] = v;
+            setSlot(reuse, +1);
+            dead -= 1;
+            return;
+        }
+
+        rebuildWith(pos, p, v);
+    }
+
+    // compact live slots and insert (v, p) in front of old slot pos
+    void rebuildWith(int pos, int p, const T& v) {
+        std::vector<int> newPrio;
+        std::vector<T> newVals;
+        newPrio.reserve(size() + 1);
+        newVals.reserve(size() + 1);
+
+        for (int s = 0; s <= numSlots; ++s) {
+            if (s == pos) {
+                newPrio.push_back(p);
+                newVals.push_back(v);
+            }
+            if (s < numSlots && liveSlot(s)) {
+                newPrio.push_back(prio[s]);
+                newVals.push_back(vals[s]);
+            }
+        }
+
+        prio.swap(newPrio);
+        vals.swap(newVals);
+        numSlots = static_cast<int>(prio.size());
+        dead = 0;
+        buildCounts();
+    }
+};
+
+#ifndef NO_DEMO_MAIN
+int main() {
+    int maxP = 1000;
+    PriorityStructure<int> ps(maxP);
+
+    std::vector<std::pair<int,int>> elems;
+    elems.push_back({100, 10});   // value=100, priority=10
+    elems.push_back({200, 150});
+    elems.push_back({300, 999});
+    elems.push_back({400, 500});
+    elems.push_back({500, 1});
+    elems.push_back({600, 750});
+    elems.push_back({700, 250});
+    elems.push_back({800, 900});
+    elems.push_back({900, 333});
+    elems.push_back({1000, 42});
+    elems.push_back({1100, 600});
+    elems.push_back({1200, 700});
+    elems.push_back({1300, 800});
+    elems.push_back({1400, 5});
+    elems.push_back({1500, 444});
+    elems.push_back({1600, 222});
+    elems.push_back({1700, 321});
+    elems.push_back({1800, 888});
+    elems.push_back({1900, 50});
+    elems.push_back({2000, 430});
+
+    ps.initialize(elems);
+
+    std::cout << "Size after initialize: " << ps.size() << "\n\n";
+
+    // Print elements in order of rank
+    std::cout << "By rank (k-th largest priority):\n";
+    int n = ps.size();
+    for (int k = 1; k <= n; ++k) {
+        int v = ps.query(k);
+        std::cout << "  k=" << k << " -> value=" << v << "\n";
+    }
+
+    // Print value and rank returned by find(p)
+    std::cout << "\nBy explicit priority (find):\n";
+    for (const auto& [val, p] : elems) {
+        auto [v, rank] = ps.find(p);
+        std::cout << "  priority=" << p
+                  << " -> value=" << v
+                  << ", rank=" << rank << "\n";
+    }
+
+    // Move a few elements around; exercises dead-slot reuse and rebuild
+    ps.updatePriority(1, 998);    // 300: 999 -> 998, reuses its own slot
+    ps.updatePriority(20, 1000);  // 500: 1 -> 1000, forces a rebuild
+    ps.updatePriority(5, 2);      // 1300: 800 -> 2
+
+    std::cout << "\nAfter updatePriority:\n";
+    for (int k = 1; k <= n; ++k) {
+        std::cout << "  k=" << k << " -> value=" << ps.query(k) << "\n";
+    }
+
+    int j = ps.nextWith(3, [](const int& v) { return v % 500 == 0; });
+    std::cout << "\nnextWith(3, v % 500 == 0) = " << j
+              << " (value=" << ps.query(j) << ")\n";
+
+    // same search through the gather kernel: table[v] = (v % 500 == 0)
+    std::vector<int> table(2001, 0);
+    for (int v = 0; v <= 2000; v += 500) {
+        table[v] = 1;
+    }
+    std::cout << "nextWithGather(3, table[v] == 1) = "
+              << ps.nextWithGather(3, table.data(), 1) << "\n";
+
+    return 0;
+}
+#endif
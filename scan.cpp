@@ -1,47 +1,375 @@
 #include <iostream>
 #include <vector>
-#include <set>
 #include <map>
+#include <algorithm>
+#include <cstdint>
+#include <omp.h>
 
 
 // Corresponds to Lemma 3.2
 
 
-std::vector<int> bfs_array(const std::vector<std::vector<int>>& adj, int s, int L) { // could be recursive
-    int n = adj.size();
-    
+// in-place inclusive prefix sum, blocked over the available threads
+inline void parallelPrefixSum(std::vector<int>& a) {
+    int m = static_cast<int>(a.size());
+    int nt = (m < (1 << 16)) ? 1 : omp_get_max_threads();
+    std::vector<int> blockSum(nt + 1, 0);
 
-    std::vector<int> dist(n, L + 1);
+    #pragma omp parallel num_threads(nt)
+    {
+        int t  = omp_get_thread_num();
+        int lo = static_cast<int>(static_cast<long long>(m) * t / nt);
+        int hi = static_cast<int>(static_cast<long long>(m) * (t + 1) / nt);
 
-    // S(0), S(1), ..., S(L)
-    std::vector<std::set<int>> levels(L+1);
+        for (int i = lo + 1; i < hi; ++i) {
+            a[i] += a[i - 1];
+        }
+        blockSum[t + 1] = (lo < hi ? a[hi - 1] : 0);
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            for (int u = 1; u <= nt; ++u) {
+                blockSum[u] += blockSum[u - 1];
+            }
+        }
+
+        for (int i = lo; i < hi; ++i) {
+            a[i] += blockSum[t];
+        }
+    }
+}
+
+
+// Compressed sparse row graph: the out-neighbors of v are
+// targets[offsets[v] .. offsets[v+1]), each row sorted.  Deleted edges are
+// tombstoned in a bitmap (allocated on first delete) instead of being removed,
+// so edge positions stay stable and rows stay contiguous.
+struct CSRGraph {
+    int n = 0;
+    std::vector<int> offsets;          // size n+1
+    std::vector<int> targets;          // size m
+    std::vector<uint64_t> deleted;     // tombstones by edge position, empty if none
+
+    CSRGraph() = default;
+
+    explicit CSRGraph(const std::vector<std::vector<int>>& adj)
+        : n(adj.size()), offsets(adj.size() + 1, 0) {
+        for (int v = 0; v < n; ++v) {
+            offsets[v + 1] = offsets[v] + static_cast<int>(adj[v].size());
+        }
+        targets.resize(offsets[n]);
+
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int v = 0; v < n; ++v) {
+            std::copy(adj[v].begin(), adj[v].end(), targets.begin() + offsets[v]);
+            std::sort(targets.begin() + offsets[v], targets.begin() + offsets[v + 1]);
+        }
+    }
+
+    int numVertices() const { return n; }
+    int numEdges() const { return static_cast<int>(targets.size()); }
+    int degree(int v) const { return offsets[v + 1] - offsets[v]; }
+
+    bool isDeleted(int e) const {
+        return !deleted.empty() &&
+               ((__atomic_load_n(&deleted[e >> 6], __ATOMIC_RELAXED) >> (e & 63)) & 1);
+    }
+
+    // allocate the tombstone bitmap up front; removeEdge is then safe to call
+    // concurrently for distinct edges
+    void allocateTombstones() {
+        if (deleted.empty()) {
+            deleted.assign((targets.size() + 63) / 64, 0);
+        }
+    }
+
+    // position of a live edge (u, v), or -1
+    int findEdge(int u, int v) const {
+        auto first = targets.begin() + offsets[u];
+        auto last  = targets.begin() + offsets[u + 1];
+        for (auto it = std::lower_bound(first, last, v); it != last && *it == v; ++it) {
+            int e = static_cast<int>(it - targets.begin());
+            if (!isDeleted(e)) {
+                return e;
+            }
+        }
+        return -1;
+    }
+
+    // tombstone edge (u, v); false if there is no live such edge
+    bool removeEdge(int u, int v) {
+        int e = findEdge(u, v);
+        if (e < 0) {
+            return false;
+        }
+        allocateTombstones();
+        uint64_t bit = uint64_t(1) << (e & 63);
+        return !(__atomic_fetch_or(&deleted[e >> 6], bit, __ATOMIC_RELAXED) & bit);
+    }
+
+    // f(u) for every live out-neighbor u of v
+    template <typename F>
+    void forEachNeighbor(int v, F&& f) const {
+        for (int e = offsets[v]; e < offsets[v + 1]; ++e) {
+            if (!isDeleted(e)) {
+                f(targets[e]);
+            }
+        }
+    }
+
+    // true if f(u) holds for some live out-neighbor u of v; stops at the first one
+    template <typename F>
+    bool anyNeighbor(int v, F&& f) const {
+        for (int e = offsets[v]; e < offsets[v + 1]; ++e) {
+            if (!isDeleted(e) && f(targets[e])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // reverse graph over the live edges: row v lists the in-neighbors of v, sorted
+    CSRGraph transpose() const {
+        CSRGraph R;
+        R.n = n;
+        R.offsets.assign(n + 1, 0);
+
+        // in-degree counts, shifted by one for the prefix sum
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int u = 0; u < n; ++u) {
+            forEachNeighbor(u, [&](int v) {
+                __atomic_fetch_add(&R.offsets[v + 1], 1, __ATOMIC_RELAXED);
+            });
+        }
+        parallelPrefixSum(R.offsets);
+
+        R.targets.resize(R.offsets[n]);
+        std::vector<int> fill(R.offsets.begin(), R.offsets.end() - 1);
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int u = 0; u < n; ++u) {
+            forEachNeighbor(u, [&](int v) {
+                R.targets[__atomic_fetch_add(&fill[v], 1, __ATOMIC_RELAXED)] = u;
+            });
+        }
+
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int v = 0; v < n; ++v) {
+            std::sort(R.targets.begin() + R.offsets[v], R.targets.begin() + R.offsets[v + 1]);
+        }
+        return R;
+    }
+};
+
+
+// frontier size below which a level is expanded without opening a team
+constexpr int BFS_PARALLEL_THRESH = 1 << 10;
+
+// Direction-optimizing heuristic (Beamer et al.): go bottom-up once the edges
+// out of the frontier exceed 1/alpha of the edges out of unvisited vertices,
+// and back top-down once the frontier holds fewer than n/beta vertices.
+constexpr int BFS_ALPHA = 15;
+constexpr int BFS_BETA  = 18;
+
+enum class BFSDirection { TopDown, BottomUp };
+
+// per-thread buffers for building a frontier, reused across levels
+struct FrontierBuffers {
+    std::vector<std::vector<int>> local;
+    std::vector<size_t> offset;
+
+    FrontierBuffers() : local(omp_get_max_threads()), offset(local.size() + 1, 0) {}
+
+    // called by every thread of the team: concatenate the buffers into out
+    void concat(std::vector<int>& out) {
+        #pragma omp single
+        {
+            int nt = omp_get_num_threads();
+            for (int q = 0; q < nt; ++q) {
+                offset[q + 1] = offset[q] + local[q].size();
+            }
+            out.resize(offset[nt]);
+        }
+
+        int t = omp_get_thread_num();
+        std::copy(local[t].begin(), local[t].end(), out.begin() + offset[t]);
+    }
+};
+
+// Top-down step S(i) -> S(i+1): a vertex is claimed by a CAS of dist[u] from
+// unseen to d, so it enters exactly one thread's buffer.
+// forEachNeighbor(v, f) calls f(u) for every out-neighbor u of v.
+template <typename ForEachNeighbor>
+void bfs_top_down_step(const std::vector<int>& curr, std::vector<int>& next,
+                       std::vector<int>& dist, int d, int unseen,
+                       FrontierBuffers& buf, const ForEachNeighbor& forEachNeighbor) {
+    const int frontier = static_cast<int>(curr.size());
+
+    #pragma omp parallel if(frontier >= BFS_PARALLEL_THRESH)
+    {
+        std::vector<int>& mine = buf.local[omp_get_thread_num()];
+        mine.clear();
+
+        #pragma omp for schedule(dynamic, 64)
+        for (int j = 0; j < frontier; ++j) {
+            forEachNeighbor(curr[j], [&](int u) {
+                int expected = unseen;
+                if (__atomic_load_n(&dist[u], __ATOMIC_RELAXED) == unseen &&
+                    __atomic_compare_exchange_n(&dist[u], &expected, d, false,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                    mine.push_back(u);
+                }
+            });
+        }
+
+        buf.concat(next);
+    }
+}
+
+// Level-synchronous BFS up to depth L over flat frontiers S(i).
+// Each thread collects its claims in a local buffer; the buffers are
+// concatenated at prefix-sum offsets to form S(i+1).
+template <typename ForEachNeighbor>
+std::vector<int> bfs_frontier(int n, int s, int L, const ForEachNeighbor& forEachNeighbor) {
+    const int unseen = L + 1;
+    std::vector<int> dist(n, unseen);
+
+    // Initialize: S(0) = {s}
+    dist[s] = 0;
+    std::vector<int> curr{s};
+    std::vector<int> next;
+    FrontierBuffers buf;
+
+    // BFS by levels up to depth L; levels are sequential, each level is parallel
+    for (int i = 0; i < L && !curr.empty(); ++i) {
+        bfs_top_down_step(curr, next, dist, i + 1, unseen, buf, forEachNeighbor);
+        curr.swap(next);
+    }
+    return dist;
+}
+
+std::vector<int> bfs_array(const std::vector<std::vector<int>>& adj, int s, int L) {
+    return bfs_frontier(static_cast<int>(adj.size()), s, L, [&](int v, const auto& f) {
+        for (int u : adj[v]) {  // iterate over out-neighbors
+            f(u);
+        }
+    });
+}
+
+// same BFS over a CSR graph; tombstoned edges are skipped
+std::vector<int> bfs_array(const CSRGraph& G, int s, int L) {
+    return bfs_frontier(G.numVertices(), s, L, [&](int v, const auto& f) {
+        G.forEachNeighbor(v, f);  // iterate over live out-neighbors
+    });
+}
+
+// Direction-optimizing BFS up to depth L.  Gr is the reverse of G (G.transpose()).
+// Top-down levels expand the frontier vector as above; bottom-up levels keep the
+// frontier as a bitmap and let every unvisited v look for an in-neighbor in it,
+// stopping at the first hit.  The direction chosen for each level is appended
+// to *directions if given.
+std::vector<int> bfs_array(const CSRGraph& G, const CSRGraph& Gr, int s, int L,
+                           std::vector<BFSDirection>* directions = nullptr,
+                           int alpha = BFS_ALPHA, int beta = BFS_BETA) {
+    const int n = G.numVertices();
+    const int words = (n + 63) / 64;
+    const int unseen = L + 1;
+    std::vector<int> dist(n, unseen);
 
-    // Initialize
     dist[s] = 0;
-    levels[0].insert(s);
+    std::vector<int> curr{s};
+    std::vector<int> next;
+    std::vector<uint64_t> currBits;
+    std::vector<uint64_t> nextBits;
+    FrontierBuffers buf;
+
+    if (directions) {
+        directions->clear();
+    }
 
-    // BFS by levels up to depth L
-    // levels are sequential
-    for (int i = 0; i < L; ++i) {
-        const std::set<int>& curr = levels[i];
-        std::set<int>& next = levels[i + 1];
+    bool bottomUp = false;
+    long long frontierSize  = 1;
+    long long frontierEdges = G.degree(s);                 // m_f
+    long long unseenEdges   = G.numEdges() - G.degree(s);  // m_u
 
+    for (int i = 0; i < L && frontierSize > 0; ++i) {
+        const int d = i + 1;
 
-        if (curr.empty()) {
-            break;
+        if (!bottomUp && frontierEdges > unseenEdges / alpha) {
+            // vector -> bitmap
+            currBits.assign(words, 0);
+            #pragma omp parallel for if(curr.size() >= BFS_PARALLEL_THRESH)
+            for (size_t j = 0; j < curr.size(); ++j) {
+                __atomic_fetch_or(&currBits[curr[j] >> 6], uint64_t(1) << (curr[j] & 63),
+                                  __ATOMIC_RELAXED);
+            }
+            bottomUp = true;
+        } else if (bottomUp && frontierSize < n / beta) {
+            // bitmap -> vector
+            #pragma omp parallel if(words * 64 >= BFS_PARALLEL_THRESH)
+            {
+                std::vector<int>& mine = buf.local[omp_get_thread_num()];
+                mine.clear();
+
+                #pragma omp for schedule(static)
+                for (int w = 0; w < words; ++w) {
+                    for (uint64_t bits = currBits[w]; bits; bits &= bits - 1) {
+                        mine.push_back(w * 64 + __builtin_ctzll(bits));
+                    }
+                }
+
+                buf.concat(curr);
+            }
+            bottomUp = false;
         }
 
-        // within level we parallelize expaniding the fringe
+        if (directions) {
+            directions->push_back(bottomUp ? BFSDirection::BottomUp : BFSDirection::TopDown);
+        }
 
-        
-        for (int v : curr) {  // iterate over nodes
-            for (int u : adj[v]) {  // iterate over out-neighbors
-                if (dist[u]>i+1) {
-                    dist[u]=i+1;
-                    next.insert(u);  // critical?
+        long long newSize = 0;
+        long long newEdges = 0;
+        if (bottomUp) {
+            // each word of the next bitmap is owned by one thread: no atomics needed
+            nextBits.assign(words, 0);
+            #pragma omp parallel for schedule(dynamic, 64) reduction(+:newSize, newEdges) \
+                    if(words * 64 >= BFS_PARALLEL_THRESH)
+            for (int w = 0; w < words; ++w) {
+                uint64_t found = 0;
+                int hi = std::min(n, w * 64 + 64);
+                for (int v = w * 64; v < hi; ++v) {
+                    if (dist[v] != unseen) {
+                        continue;
+                    }
+                    bool hit = Gr.anyNeighbor(v, [&](int u) {
+                        return (currBits[u >> 6] >> (u & 63)) & 1;
+                    });
+                    if (hit) {
+                        dist[v] = d;
+                        found |= uint64_t(1) << (v & 63);
+                        newSize += 1;
+                        newEdges += G.degree(v);
+                    }
                 }
+                nextBits[w] = found;
+            }
+            currBits.swap(nextBits);
+        } else {
+            bfs_top_down_step(curr, next, dist, d, unseen, buf, [&](int v, const auto& f) {
+                G.forEachNeighbor(v, f);
+            });
+            curr.swap(next);
+
+            newSize = static_cast<long long>(curr.size());
+            #pragma omp parallel for reduction(+:newEdges) if(newSize >= BFS_PARALLEL_THRESH)
+            for (long long j = 0; j < newSize; ++j) {
+                newEdges += G.degree(curr[j]);
             }
         }
+
+        frontierSize  = newSize;
+        frontierEdges = newEdges;
+        unseenEdges  -= newEdges;
     }
     return dist;
 }
@@ -52,6 +380,7 @@ std::vector<int> bfs_array(const std::vector<std::vector<int>>& adj, int s, int
 
 
 
+#ifndef NO_DEMO_MAIN
 int main() {
     // Example graph:
     //
@@ -82,5 +411,29 @@ int main() {
         std::cout << "  v = " << v << ", Dist[v] = " << res[v] << "\n";
     }
 
+    // same graph in CSR form, after deleting 1 -> 3
+    CSRGraph G(adj);
+    G.removeEdge(1, 3);
+    auto resCSR = bfs_array(G, 0, 2);
+
+    std::cout << "\nDist array over CSR without 1 -> 3 (L = 2):\n";
+    for (int v = 0; v < n; ++v) {
+        std::cout << "  v = " << v << ", Dist[v] = " << resCSR[v] << "\n";
+    }
+
+    // direction-optimizing BFS over the same CSR graph and its reverse
+    std::vector<BFSDirection> dirs;
+    auto resDO = bfs_array(G, G.transpose(), 0, 3, &dirs);
+
+    std::cout << "\nDirection-optimizing BFS (L = 3):\n";
+    for (int v = 0; v < n; ++v) {
+        std::cout << "  v = " << v << ", Dist[v] = " << resDO[v] << "\n";
+    }
+    for (size_t i = 0; i < dirs.size(); ++i) {
+        std::cout << "  level " << i + 1 << ": "
+                  << (dirs[i] == BFSDirection::BottomUp ? "bottom-up" : "top-down") << "\n";
+    }
+
     return 0;
 }
+#endif
@@ -10,13 +10,20 @@ public:
     explicit PriorityStructure(int maxPriority)
         : maxP(maxPriority), root(nullptr) {}
 
+    PriorityStructure(const PriorityStructure&) = delete;
+    PriorityStructure& operator=(const PriorityStructure&) = delete;
+
+    ~PriorityStructure() {
+        destroy(root);
+    }
+
     // **API FUNCTION**
     // INITIALIZE({(v1, p1), ..., (vl, pl)})
     // initialize segment tree from list of (value, priority) pairs
     void initialize(const std::vector<std::pair<T,int>>& elems) {
-        // TODO: in case we ever call initialize multiple times, need to delete original tree
         // TODO: is this right?  not using any kind of sorting...
-        root = nullptr;  // redundant assuming initialize is always first call
+        destroy(root);
+        root = nullptr;
 
         for (const auto& [v, p] : elems) {
             if (p < 1 || p > maxP) { // priorities must be bounded
@@ -145,6 +152,15 @@ private:
     int maxP;           // max priority
     Node* root;         // root
 
+    // free a subtree
+    static void destroy(Node* node) {
+        if (node) {
+            destroy(node->left);
+            destroy(node->right);
+            delete node;
+        }
+    }
+
     // create node if null
     static void ensureNode(Node*& node) {
         if (!node) {
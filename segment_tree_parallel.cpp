@@ -10,38 +10,64 @@ public:
     explicit PriorityStructure(int maxPriority)
         : maxP(maxPriority), root(nullptr) {}
 
+    PriorityStructure(const PriorityStructure&) = delete;
+    PriorityStructure& operator=(const PriorityStructure&) = delete;
+
+    ~PriorityStructure() {
+        destroy(root);
+    }
+
     // **API FUNCTION**
     // INITIALIZE({(v1, p1), ..., (vl, pl)})
     // initialize segment tree from list of (value, priority) pairs
+    // Elements are inserted concurrently through tryInsert.  Nothing is thrown
+    // inside the parallel region: the smallest failing index is recorded and
+    // its error rethrown afterwards, leaving the structure empty.
     void initialize(const std::vector<std::pair<T,int>>& elems) {
-    root = nullptr;
-
-    int m = elems.size();
-
-    // Parallelize over the elements: each iteration corresponds to one (v,p).
-    #pragma omp parallel for
-    for (int i = 0; i < m; ++i) {
-        const T& v = elems[i].first;
-        int p = elems[i].second;
-
-        // Local validation (doesn't touch shared state)
-        if (p < 1 || p > maxP) {
-            // Throwing exceptions from inside OpenMP regions is messy in practice,
-            // but this is fine as a "dummy" example.
-            throw std::out_of_range("priority out of range in initialize");
+        destroy(root);
+        root = nullptr;
+
+        int m = elems.size();
+        int firstBad = m;  // smallest index whose insert failed
+
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int i = 0; i < m; ++i) {
+            if (tryInsert(elems[i].first, elems[i].second) != InsertStatus::Ok) {
+                int cur = __atomic_load_n(&firstBad, __ATOMIC_RELAXED);
+                while (i < cur &&
+                       !__atomic_compare_exchange_n(&firstBad, &cur, i, false,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                }
+            }
         }
 
-        // Now we need to touch the shared tree (root and its descendants).
-        // We *must* serialize this to avoid races on node creation and cnt updates.
-        #pragma omp critical(PriorityTreeInsert)
-        {
-            if (presentPriority(root, 1, maxP, p)) { // priorities must be unique
-                throw std::logic_error("duplicate priority in initialize");
+        if (firstBad < m) {
+            destroy(root);
+            root = nullptr;
+            int p = elems[firstBad].second;
+            if (p < 1 || p > maxP) {
+                throw std::out_of_range("priority out of range in initialize");
             }
-            insert(root, 1, maxP, p, v);
+            throw std::logic_error("duplicate priority in initialize");
+        }
+    }
+
+    // **CONCURRENT INSERT**
+    // Add (v, p) to the structure.  Any number of threads may call this at the
+    // same time (e.g. streaming producers filling a structure that is being
+    // built), but not together with any other operation: the rest of the API
+    // sees the inserted elements once the producers are done.
+    // Throws on the calling thread, so inside an OpenMP region catch it there.
+    void insertConcurrent(const T& v, int p) {
+        switch (tryInsert(v, p)) {
+            case InsertStatus::OutOfRange:
+                throw std::out_of_range("insertConcurrent: priority out of range");
+            case InsertStatus::Duplicate:
+                throw std::logic_error("insertConcurrent: priority already present");
+            default:
+                return;
         }
     }
-}
 
     // number of elements currently stored
     int size() const {
@@ -130,7 +156,7 @@ public:
             if (end > n) end = n;
 
             // Parallel scan of QUERY(p..end)
-            int best = nextWithRange(p, end, f)
+            int best = nextWithRange(p, end, f);
 
             if (best <= end) {
                 return best;  // found smallest j in this phase
@@ -151,6 +177,7 @@ public:
         }
 
         // Clamp range
+        if (min < 1)  min = 1;
         if (max > n)  max = n;
         if (min > max) {
             return n + 1;
@@ -158,9 +185,9 @@ public:
 
         int best = n + 1;
 
-        // Parallel loop over j in [L, R].
+        // Parallel loop over j in [min, max].
         #pragma omp parallel for reduction(min:best)
-        for (int j = L; j <= R; ++j) {
+        for (int j = min; j <= max; ++j) {
             const T& val = query(j);
             if (f(val) && j < best) {
                 best = j;
@@ -185,6 +212,75 @@ private:
     int maxP;           // max priority
     Node* root;         // root
 
+    // free a subtree
+    static void destroy(Node* node) {
+        if (node) {
+            destroy(node->left);
+            destroy(node->right);
+            delete node;
+        }
+    }
+
+    enum class InsertStatus { Ok, OutOfRange, Duplicate };
+
+    // Lock-free insert of (v, p), safe against concurrent tryInsert calls.
+    // Missing nodes on the root-to-leaf path are published by CAS on the child
+    // pointer (a loser frees its node and follows the winner's).  The leaf is
+    // then claimed by CAS on present, which rejects duplicates before any cnt
+    // has changed; only then are the counts on the path incremented.
+    InsertStatus tryInsert(const T& v, int p) {
+        if (p < 1 || p > maxP) {
+            return InsertStatus::OutOfRange;
+        }
+
+        Node* path[64];     // depth is at most ceil(log2(maxP)) + 1 <= 33
+        int depth = 0;
+        Node** link = &root;
+        int L = 1, R = maxP;
+        for (;;) {
+            Node* node = childOrCreate(*link);
+            path[depth++] = node;
+            if (L == R) {
+                break;
+            }
+            int mid = (L + R) / 2;
+            if (p <= mid) {
+                link = &node->left;
+                R = mid;
+            } else {
+                link = &node->right;
+                L = mid + 1;
+            }
+        }
+
+        Node* leaf = path[depth - 1];
+        bool expected = false;
+        if (!__atomic_compare_exchange_n(&leaf->present, &expected, true, false,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return InsertStatus::Duplicate;
+        }
+        leaf->value = v;
+        for (int d = 0; d < depth; ++d) {
+            __atomic_fetch_add(&path[d]->cnt, 1, __ATOMIC_RELAXED);
+        }
+        return InsertStatus::Ok;
+    }
+
+    // the node at link, created by CAS if there is none yet
+    static Node* childOrCreate(Node*& link) {
+        Node* node = __atomic_load_n(&link, __ATOMIC_ACQUIRE);
+        if (node) {
+            return node;
+        }
+        Node* fresh = new Node();
+        if (__atomic_compare_exchange_n(&link, &node, fresh, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return fresh;
+        }
+        delete fresh;   // another thread got there first; node is its child
+        return node;
+    }
+
     // create node if null
     static void ensureNode(Node*& node) {
         if (!node) {